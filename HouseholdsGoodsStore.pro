@@ -1,9 +1,11 @@
-QT += core gui sql widgets printsupport
+QT += core gui sql widgets printsupport network concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 CONFIG += c++17
 
+include(database.pri)
+
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
@@ -12,14 +14,25 @@ SOURCES += \
     addproductform.cpp \
     addsupplyform.cpp \
     adminwindow.cpp \
+    backupworker.cpp \
     cartobserver.cpp \
     cashierwindow.cpp \
+    catalogimporter.cpp \
     clientcartform.cpp \
     clientwindow.cpp \
-    database.cpp \
+    csvexporter.cpp \
     main.cpp \
+    productsearchmodel.cpp \
+    printspooler.cpp \
+    receiptbatchexporter.cpp \
     authwindow.cpp \
+    receiptcache.cpp \
+    receiptitemview.cpp \
+    receiptrenderer.cpp \
     salesreceiptform.cpp \
+    salessnapshot.cpp \
+    stockreconciler.cpp \
+    storeservice.cpp \
     windowfactory.cpp
 
 HEADERS += \
@@ -27,12 +40,23 @@ HEADERS += \
     addsupplyform.h \
     adminwindow.h \
     authwindow.h \
+    backupworker.h \
     cartobserver.h \
     cashierwindow.h \
+    catalogimporter.h \
     clientcartform.h \
     clientwindow.h \
-    database.h \
+    csvexporter.h \
+    productsearchmodel.h \
+    printspooler.h \
+    receiptbatchexporter.h \
+    receiptcache.h \
+    receiptitemview.h \
+    receiptrenderer.h \
     salesreceiptform.h \
+    salessnapshot.h \
+    stockreconciler.h \
+    storeservice.h \
     windowfactory.h
 
 FORMS += \
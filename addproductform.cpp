@@ -1,11 +1,14 @@
 #include "addproductform.h"
 #include "ui_addproductform.h"
+#include "categorycache.h"
 #include <QMessageBox>
 
 AddProductForm::AddProductForm(int productId, QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::AddProductForm)
     , productId(productId)
+    , loadedVersion(0)
+    , loadedStock(0)
 {
     ui->setupUi(this);
 
@@ -35,7 +38,7 @@ void AddProductForm::loadCategories()
 
     if (!db.connectToDatabase()) return;
 
-    QList<ProductCategory> categories = db.getAllCategories();
+    QList<ProductCategory> categories = CategoryCache::instance().categories(db);
     foreach (const ProductCategory &category, categories) {
         ui->cbCategory->addItem(category.name, category.id);
     }
@@ -59,6 +62,9 @@ void AddProductForm::loadProductData()
     ui->dsbPurchasePrice->setValue(product.purchasePrice);
     ui->dsbRetailPrice->setValue(product.retailPrice);
     ui->sbStock->setValue(product.stock);
+
+    loadedVersion = product.version;
+    loadedStock = product.stock;
 }
 
 bool AddProductForm::validateForm()
@@ -108,10 +114,23 @@ void AddProductForm::onSaveClicked()
     product.purchasePrice = ui->dsbPurchasePrice->value();
     product.retailPrice = ui->dsbRetailPrice->value();
     product.stock = ui->sbStock->value();
+    product.version = loadedVersion;
 
     bool success = false;
     if (productId > 0) {
-        success = db.updateProduct(product);
+        // Остаток передается как изменение относительно загруженного значения,
+        // продажи, прошедшие пока форма была открыта, сохраняются
+        Database::UpdateResult result = db.updateProduct(product, product.stock - loadedStock);
+
+        if (result == Database::UpdateConflict) {
+            QMessageBox::warning(this, "Конфликт",
+                                 "Товар был изменен другим пользователем. "
+                                 "Загружены актуальные данные, проверьте их и сохраните снова.");
+            loadProductData();
+            return;
+        }
+
+        success = result == Database::UpdateOk;
     } else {
         success = db.addProduct(product);
     }
@@ -23,6 +23,8 @@ private slots:
 private:
     Ui::AddProductForm *ui;
     int productId;
+    int loadedVersion;
+    int loadedStock;
     Database db;
 
     void loadCategories();
@@ -1,23 +1,46 @@
 #include "addsupplyform.h"
 #include "ui_addsupplyform.h"
 #include <QMessageBox>
+#include <QHeaderView>
+#include <QAbstractProxyModel>
+#include <algorithm>
 #include "addproductform.h"
+#include "catalogevents.h"
+#include "money.h"
+
+enum LineColumn {
+    ColumnProduct,
+    ColumnQuantity,
+    ColumnPrice,
+    ColumnTotal
+};
 
 AddSupplyForm::AddSupplyForm(QWidget *parent, int userId)
     : QDialog(parent)
     , ui(new Ui::AddSupplyForm)
     , currentUserId(userId)
+    , searchModel(new ProductSearchModel(db, this))
+    , completer(new QCompleter(searchModel, this))
 {
     ui->setupUi(this);
     ui->dteDate->setDateTime(QDateTime::currentDateTime());
+    selectedProduct.id = -1;
+
+    db.connectToDatabase();
 
-    loadProducts();
+    setupTable();
+    setupProductPicker();
 
     connect(ui->pbSaveSupply, &QPushButton::clicked, this, &AddSupplyForm::onSaveClicked);
     connect(ui->pbCancelSupply, &QPushButton::clicked, this, &AddSupplyForm::onCancelClicked);
-    connect(ui->cbProduct, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &AddSupplyForm::onProductChanged);
     connect(ui->pbAddNewProduct, &QPushButton::clicked, this, &AddSupplyForm::onAddNewProductClicked);
-    connect(ui->sbQuantity, QOverload<int>::of(&QSpinBox::valueChanged), this, &AddSupplyForm::onQuantityChanged);
+    connect(ui->pbAddLine, &QPushButton::clicked, this, &AddSupplyForm::onAddLineClicked);
+    connect(ui->leScan, &QLineEdit::returnPressed, this, &AddSupplyForm::onScanEntered);
+    connect(ui->pbRemoveLine, &QPushButton::clicked, this, &AddSupplyForm::onRemoveLineClicked);
+    connect(ui->twLines, &QTableWidget::itemChanged, this, &AddSupplyForm::onLineChanged);
+    connect(&CatalogEvents::instance(), &CatalogEvents::productsChanged, this, &AddSupplyForm::onCatalogChanged);
+
+    ui->leScan->setFocus();
 }
 
 AddSupplyForm::~AddSupplyForm()
@@ -25,35 +48,95 @@ AddSupplyForm::~AddSupplyForm()
     delete ui;
 }
 
-void AddSupplyForm::loadProducts()
+void AddSupplyForm::setupTable()
+{
+    ui->twLines->setColumnCount(4);
+    ui->twLines->setHorizontalHeaderLabels({"Товар", "Количество", "Цена", "Сумма"});
+    ui->twLines->setSelectionBehavior(QAbstractItemView::SelectRows);
+    ui->twLines->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    ui->twLines->setEditTriggers(QAbstractItemView::DoubleClicked | QAbstractItemView::EditKeyPressed);
+    ui->twLines->verticalHeader()->setVisible(false);
+
+    ui->twLines->horizontalHeader()->setSectionResizeMode(ColumnProduct, QHeaderView::Stretch);
+    ui->twLines->horizontalHeader()->setSectionResizeMode(ColumnQuantity, QHeaderView::ResizeToContents);
+    ui->twLines->horizontalHeader()->setSectionResizeMode(ColumnPrice, QHeaderView::ResizeToContents);
+    ui->twLines->horizontalHeader()->setSectionResizeMode(ColumnTotal, QHeaderView::ResizeToContents);
+}
+
+void AddSupplyForm::setupProductPicker()
 {
-    ui->cbProduct->clear();
-    ui->cbProduct->addItem("Выберите товар", -1);
+    // Модель уже отфильтрована запросом, completer ее только показывает
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer->setCaseSensitivity(Qt::CaseInsensitive);
+    completer->setMaxVisibleItems(15);
+    ui->leProduct->setCompleter(completer);
 
-    if (!db.connectToDatabase()) return;
+    connect(ui->leProduct, &QLineEdit::textEdited, this, &AddSupplyForm::onProductEdited);
+    connect(ui->leProduct, &QLineEdit::returnPressed, this, &AddSupplyForm::onAddLineClicked);
+    connect(completer, QOverload<const QModelIndex &>::of(&QCompleter::activated),
+            this, &AddSupplyForm::onProductActivated);
+}
 
-    QList<Product> products = db.getAllProducts();
-    foreach (const Product &product, products) {
-        ui->cbProduct->addItem(product.name + " (" + product.article + ")", product.id);
+void AddSupplyForm::rememberProduct(const Product &product)
+{
+    products.insert(product.id, product);
+    productIdsByArticle.insert(product.article, product.id);
+}
+
+void AddSupplyForm::addLine(const Product &product, int quantity)
+{
+    // Повторный скан того же товара увеличивает количество в его строке
+    for (int row = 0; row < ui->twLines->rowCount(); row++) {
+        QTableWidgetItem *quantityItem = ui->twLines->item(row, ColumnQuantity);
+        if (ui->twLines->item(row, ColumnProduct)->data(Qt::UserRole).toInt() == product.id) {
+            quantityItem->setData(Qt::EditRole, quantityItem->data(Qt::EditRole).toInt() + quantity);
+            ui->twLines->selectRow(row);
+            return;
+        }
     }
+
+    ui->twLines->blockSignals(true);
+
+    int row = ui->twLines->rowCount();
+    ui->twLines->insertRow(row);
+
+    QTableWidgetItem *nameItem = new QTableWidgetItem(product.name + " (" + product.article + ")");
+    nameItem->setData(Qt::UserRole, product.id);
+    nameItem->setFlags(nameItem->flags() & ~Qt::ItemIsEditable);
+    ui->twLines->setItem(row, ColumnProduct, nameItem);
+
+    QTableWidgetItem *quantityItem = new QTableWidgetItem();
+    quantityItem->setData(Qt::EditRole, quantity);
+    quantityItem->setTextAlignment(Qt::AlignCenter);
+    ui->twLines->setItem(row, ColumnQuantity, quantityItem);
+
+    QTableWidgetItem *priceItem = new QTableWidgetItem();
+    priceItem->setData(Qt::EditRole, Money::fromDouble(product.purchasePrice).toDouble());
+    priceItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    ui->twLines->setItem(row, ColumnPrice, priceItem);
+
+    QTableWidgetItem *totalItem = new QTableWidgetItem();
+    totalItem->setFlags(totalItem->flags() & ~Qt::ItemIsEditable);
+    totalItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    ui->twLines->setItem(row, ColumnTotal, totalItem);
+
+    ui->twLines->blockSignals(false);
+
+    onLineChanged(quantityItem);
+    ui->twLines->scrollToItem(nameItem);
 }
 
 void AddSupplyForm::calculateTotal()
 {
-    int productId = ui->cbProduct->currentData().toInt();
-    int quantity = ui->sbQuantity->value();
-
-    if (productId > 0 && quantity > 0) {
-        if (!db.connectToDatabase()) return;
+    Money total;
 
-        Product product = db.getProductById(productId);
-        if (product.id != -1) {
-            double total = product.purchasePrice * quantity;
-            ui->lTotalSum->setText(QString::number(total, 'f', 2));
-        }
-    } else {
-        ui->lTotalSum->setText("0");
+    for (int row = 0; row < ui->twLines->rowCount(); row++) {
+        Money price = Money::fromDouble(ui->twLines->item(row, ColumnPrice)->data(Qt::EditRole).toDouble());
+        total += price * ui->twLines->item(row, ColumnQuantity)->data(Qt::EditRole).toInt();
     }
+
+    ui->lTotalSum->setText(total.toString());
+    ui->lLinesCount->setText(QString("Строк: %1").arg(ui->twLines->rowCount()));
 }
 
 bool AddSupplyForm::validateForm()
@@ -63,14 +146,17 @@ bool AddSupplyForm::validateForm()
         return false;
     }
 
-    if (ui->cbProduct->currentData().toInt() <= 0) {
-        QMessageBox::warning(this, "Ошибка", "Выберите товар");
+    if (ui->twLines->rowCount() == 0) {
+        QMessageBox::warning(this, "Ошибка", "Добавьте товары в документ");
         return false;
     }
 
-    if (ui->sbQuantity->value() <= 0) {
-        QMessageBox::warning(this, "Ошибка", "Введите количество");
-        return false;
+    for (int row = 0; row < ui->twLines->rowCount(); row++) {
+        if (ui->twLines->item(row, ColumnQuantity)->data(Qt::EditRole).toInt() <= 0) {
+            ui->twLines->selectRow(row);
+            QMessageBox::warning(this, "Ошибка", "Введите количество");
+            return false;
+        }
     }
 
     return true;
@@ -85,25 +171,23 @@ void AddSupplyForm::onSaveClicked()
         return;
     }
 
-    Supply supply;
-    supply.supplyNumber = db.generateSupplyNumber();
-    supply.supplierName = ui->leSupplier->text();
-    supply.productId = ui->cbProduct->currentData().toInt();
-    supply.quantity = ui->sbQuantity->value();
+    SupplyDocument document;
+    document.documentNumber = db.generateSupplyNumber();
+    document.supplierName = ui->leSupplier->text();
+    document.supplyDate = ui->dteDate->dateTime();
 
-    Product product = db.getProductById(supply.productId);
-    if (product.id == -1) {
-        QMessageBox::warning(this, "Ошибка", "Товар не найден");
-        return;
+    for (int row = 0; row < ui->twLines->rowCount(); row++) {
+        Supply line;
+        line.productId = ui->twLines->item(row, ColumnProduct)->data(Qt::UserRole).toInt();
+        line.quantity = ui->twLines->item(row, ColumnQuantity)->data(Qt::EditRole).toInt();
+        line.purchasePrice = ui->twLines->item(row, ColumnPrice)->data(Qt::EditRole).toDouble();
+        document.lines.append(line);
     }
 
-    supply.purchasePrice = product.purchasePrice;
-    supply.supplyDate = ui->dteDate->dateTime();
-
-    if (db.addSupply(supply, currentUserId)) {
+    if (db.addSupplyDocument(document, currentUserId)) {
         accept();
     } else {
-        QMessageBox::warning(this, "Ошибка", "Не удалось сохранить поставку");
+        QMessageBox::warning(this, "Ошибка", "Не удалось провести документ поставки");
     }
 }
 
@@ -112,22 +196,119 @@ void AddSupplyForm::onCancelClicked()
     reject();
 }
 
-void AddSupplyForm::onProductChanged(int index)
+void AddSupplyForm::onAddNewProductClicked()
 {
-    Q_UNUSED(index);
-    calculateTotal();
+    AddProductForm productForm(-1, this);
+    productForm.exec();
 }
 
-void AddSupplyForm::onAddNewProductClicked()
+void AddSupplyForm::onProductEdited(const QString &text)
 {
-    AddProductForm productForm(-1, this);
-    if (productForm.exec() == QDialog::Accepted) {
-        loadProducts();
+    selectedProduct.id = -1;
+    searchModel->setPrefix(text);
+    completer->complete();
+}
+
+void AddSupplyForm::onProductActivated(const QModelIndex &index)
+{
+    QAbstractProxyModel *proxy = qobject_cast<QAbstractProxyModel *>(completer->completionModel());
+    QModelIndex source = proxy ? proxy->mapToSource(index) : index;
+
+    selectedProduct = searchModel->product(source.row());
+    if (selectedProduct.id != -1) {
+        rememberProduct(selectedProduct);
+        ui->sbQuantity->setFocus();
+        ui->sbQuantity->selectAll();
+    }
+}
+
+void AddSupplyForm::onCatalogChanged()
+{
+    // Кеш заполняется заново по мере выбора, цена выбранного товара перечитывается
+    products.clear();
+    productIdsByArticle.clear();
+    searchModel->refresh();
+
+    if (selectedProduct.id != -1) {
+        selectedProduct = db.getProductById(selectedProduct.id);
+        if (selectedProduct.id == -1) {
+            ui->leProduct->clear();
+        }
+    }
+}
+
+void AddSupplyForm::onAddLineClicked()
+{
+    if (selectedProduct.id == -1) {
+        QMessageBox::warning(this, "Ошибка", "Выберите товар");
+        return;
+    }
+
+    addLine(selectedProduct, ui->sbQuantity->value());
+    ui->sbQuantity->setValue(1);
+    ui->leProduct->clear();
+    selectedProduct.id = -1;
+    ui->leProduct->setFocus();
+}
+
+void AddSupplyForm::onScanEntered()
+{
+    QString article = ui->leScan->text().trimmed();
+    if (article.isEmpty()) return;
+
+    auto it = products.constFind(productIdsByArticle.value(article, -1));
+    if (it != products.constEnd()) {
+        addLine(*it, 1);
+        ui->leScan->clear();
+        return;
+    }
+
+    Product product = db.getProductByArticle(article);
+    if (product.id == -1) {
+        QMessageBox::warning(this, "Ошибка", QString("Товар с артикулом %1 не найден").arg(article));
+        ui->leScan->selectAll();
+        return;
     }
+
+    rememberProduct(product);
+    addLine(product, 1);
+    ui->leScan->clear();
 }
 
-void AddSupplyForm::onQuantityChanged(int value)
+void AddSupplyForm::onRemoveLineClicked()
 {
-    Q_UNUSED(value);
+    QModelIndexList rows = ui->twLines->selectionModel()->selectedRows();
+    std::sort(rows.begin(), rows.end(), [](const QModelIndex &a, const QModelIndex &b) {
+        return a.row() > b.row();
+    });
+
+    for (const QModelIndex &index : rows) {
+        ui->twLines->removeRow(index.row());
+    }
+
+    calculateTotal();
+}
+
+void AddSupplyForm::onLineChanged(QTableWidgetItem *item)
+{
+    if (!item || item->column() == ColumnTotal || item->column() == ColumnProduct) return;
+
+    int row = item->row();
+    QTableWidgetItem *quantityItem = ui->twLines->item(row, ColumnQuantity);
+    QTableWidgetItem *priceItem = ui->twLines->item(row, ColumnPrice);
+    QTableWidgetItem *totalItem = ui->twLines->item(row, ColumnTotal);
+    if (!quantityItem || !priceItem || !totalItem) return;
+
+    Money price = Money::fromDouble(priceItem->data(Qt::EditRole).toDouble());
+    int quantity = quantityItem->data(Qt::EditRole).toInt();
+
+    ui->twLines->blockSignals(true);
+    if (price < Money()) {
+        price = Money();
+        priceItem->setData(Qt::EditRole, 0.0);
+    }
+    totalItem->setText((price * quantity).toString());
+    ui->twLines->blockSignals(false);
+
     calculateTotal();
 }
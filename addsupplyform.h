@@ -1,8 +1,12 @@
 #ifndef ADDSUPPLYFORM_H
 #define ADDSUPPLYFORM_H
 
+#include <QCompleter>
 #include <QDialog>
+#include <QHash>
+#include <QTableWidgetItem>
 #include "database.h"
+#include "productsearchmodel.h"
 
 namespace Ui {
 class AddSupplyForm;
@@ -19,16 +23,29 @@ public:
 private slots:
     void onSaveClicked();
     void onCancelClicked();
-    void onProductChanged(int index);
     void onAddNewProductClicked();
-    void onQuantityChanged(int value);
+    void onAddLineClicked();
+    void onScanEntered();
+    void onRemoveLineClicked();
+    void onLineChanged(QTableWidgetItem *item);
+    void onProductEdited(const QString &text);
+    void onProductActivated(const QModelIndex &index);
+    void onCatalogChanged();
 
 private:
     Ui::AddSupplyForm *ui;
     Database db;
     int currentUserId;
-
-    void loadProducts();
+    ProductSearchModel *searchModel;
+    QCompleter *completer;
+    Product selectedProduct;
+    QHash<int, Product> products;
+    QHash<QString, int> productIdsByArticle;
+
+    void setupTable();
+    void setupProductPicker();
+    void rememberProduct(const Product &product);
+    void addLine(const Product &product, int quantity);
     void calculateTotal();
     bool validateForm();
 };
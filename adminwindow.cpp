@@ -5,15 +5,30 @@
 #include <QMessageBox>
 #include <QHeaderView>
 #include <QFile>
-#include <QTextStream>
 #include <QDebug>
 #include <QDateEdit>
 #include <QDialog>
 #include <QFormLayout>
 #include <QDialogButtonBox>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QDateTimeEdit>
+#include <QLineEdit>
+#include <QCheckBox>
 #include "addproductform.h"
 #include "addsupplyform.h"
 #include "salesreceiptform.h"
+#include "stockreconciler.h"
+#include "backupworker.h"
+#include "catalogimporter.h"
+#include "csvexporter.h"
+#include "salessnapshot.h"
+#include "receiptbatchexporter.h"
+#include "money.h"
+#include "categorycache.h"
+#include <QFileInfo>
+#include <QProgressDialog>
+#include <QApplication>
 
 AdminWindow::AdminWindow(QWidget *parent, int userId)
     : QWidget(parent), ui(new Ui::AdminWindow), currentUserId(userId)
@@ -53,6 +68,14 @@ AdminWindow::AdminWindow(QWidget *parent, int userId)
 
 AdminWindow::~AdminWindow()
 {
+    // Фоновые потоки (копирование, импорт) - дочерние объекты окна: уничтожить
+    // работающий QThread нельзя, поэтому просим остановиться и дожидаемся
+    const QList<QThread *> threads = findChildren<QThread *>(QString(), Qt::FindDirectChildrenOnly);
+    for (QThread *thread : threads) {
+        thread->requestInterruption();
+        thread->wait();
+    }
+
     delete ui;
 }
 
@@ -62,16 +85,32 @@ void AdminWindow::setupMenuBar()
 
     fileMenu = menuBar->addMenu("&Файл");
 
-    QAction *openAction = new QAction("&Открыть...", this);
+    QAction *openAction = new QAction("&Импорт каталога...", this);
     openAction->setShortcut(QKeySequence::Open);
     connect(openAction, &QAction::triggered, this, &AdminWindow::onFileOpen);
     fileMenu->addAction(openAction);
 
+    QAction *priceListAction = new QAction("&Прайс-лист на период...", this);
+    connect(priceListAction, &QAction::triggered, this, &AdminWindow::onFilePriceList);
+    fileMenu->addAction(priceListAction);
+
     QAction *saveAsAction = new QAction("&Сохранить как...", this);
     saveAsAction->setShortcut(QKeySequence::SaveAs);
     connect(saveAsAction, &QAction::triggered, this, &AdminWindow::onFileSaveAs);
     fileMenu->addAction(saveAsAction);
 
+    QAction *archiveAction = new QAction("&Архивировать продажи...", this);
+    connect(archiveAction, &QAction::triggered, this, &AdminWindow::onFileArchiveSales);
+    fileMenu->addAction(archiveAction);
+
+    QAction *snapshotExportAction = new QAction("&Снимок продаж для аналитики...", this);
+    connect(snapshotExportAction, &QAction::triggered, this, &AdminWindow::onFileExportSnapshot);
+    fileMenu->addAction(snapshotExportAction);
+
+    QAction *receiptsExportAction = new QAction("Чеки за период в &PDF...", this);
+    connect(receiptsExportAction, &QAction::triggered, this, &AdminWindow::onFileExportReceipts);
+    fileMenu->addAction(receiptsExportAction);
+
     fileMenu->addSeparator();
 
     QAction *exitAction = new QAction("&Выход", this);
@@ -89,6 +128,17 @@ void AdminWindow::setupMenuBar()
     connect(popularAction, &QAction::triggered, this, &AdminWindow::onReportPopular);
     reportMenu->addAction(popularAction);
 
+    snapshotSourceAction = new QAction("Отчеты по &снимку...", this);
+    snapshotSourceAction->setCheckable(true);
+    connect(snapshotSourceAction, &QAction::triggered, this, &AdminWindow::onReportUseSnapshot);
+    reportMenu->addAction(snapshotSourceAction);
+
+    reportMenu->addSeparator();
+
+    QAction *reconcileAction = new QAction("&Сверка остатков...", this);
+    connect(reconcileAction, &QAction::triggered, this, &AdminWindow::onReportReconcile);
+    reportMenu->addAction(reconcileAction);
+
     helpMenu = menuBar->addMenu("&Помощь");
 
     QAction *referenceAction = new QAction("&Справка...", this);
@@ -155,6 +205,15 @@ void AdminWindow::setupProductsPage()
     deleteAction->setEnabled(false);
     connect(deleteAction, &QAction::triggered, this, &AdminWindow::onDeleteProduct);
 
+    productsToolBar->addSeparator();
+
+    QAction *bulkPriceAction = productsToolBar->addAction("Изменить цены...");
+    connect(bulkPriceAction, &QAction::triggered, this, &AdminWindow::onBulkChangePrices);
+
+    QAction *bulkCategoryAction = productsToolBar->addAction("Сменить категорию...");
+    bulkCategoryAction->setEnabled(false);
+    connect(bulkCategoryAction, &QAction::triggered, this, &AdminWindow::onBulkMoveCategory);
+
     productsTable = new QTableWidget();
     productsTable->setColumnCount(9);
     QStringList productHeaders = {"ID", "Артикул", "Название", "Категория",
@@ -162,7 +221,7 @@ void AdminWindow::setupProductsPage()
                                   "Остаток", "Создан", "Обновлен"};
     productsTable->setHorizontalHeaderLabels(productHeaders);
     productsTable->setSelectionBehavior(QAbstractItemView::SelectRows);
-    productsTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    productsTable->setSelectionMode(QAbstractItemView::ExtendedSelection);
     productsTable->horizontalHeader()->setStretchLastSection(true);
     productsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
 
@@ -264,6 +323,7 @@ void AdminWindow::loadProductsData()
     }
 
     QList<Product> products = db.getAllProducts();
+    CategoryCache::instance().resolve(db, products);
     updateProductsTable(products);
 }
 
@@ -297,6 +357,7 @@ void AdminWindow::searchProducts(const QString &text)
     if (!db.connectToDatabase()) return;
 
     QList<Product> allProducts = db.getAllProducts();
+    CategoryCache::instance().resolve(db, allProducts);
     QList<Product> filteredProducts;
 
     if (text.isEmpty()) {
@@ -433,7 +494,64 @@ void AdminWindow::updateSalesTable(const QList<Sale> &sales)
 
 void AdminWindow::onFileOpen()
 {
-    QMessageBox::information(this, "Открыть", "Функция открытия файла будет реализована позже");
+    QString fileName = QFileDialog::getOpenFileName(this, "Импорт каталога", "",
+                                                    "Каталог (*.csv *.jsonl *.ndjson);;All Files (*)");
+
+    if (fileName.isEmpty()) return;
+
+    CatalogImporter *importer = new CatalogImporter(fileName, currentUserId, this);
+
+    QProgressDialog *progressDialog = new QProgressDialog("Импорт каталога...", "Отмена", 0, 100, this);
+    progressDialog->setWindowModality(Qt::WindowModal);
+    progressDialog->setMinimumDuration(300);
+
+    connect(importer, &CatalogImporter::progress, progressDialog, &QProgressDialog::setValue);
+    connect(progressDialog, &QProgressDialog::canceled, importer, &QThread::requestInterruption);
+
+    connect(importer, &QThread::finished, this, [this, importer, progressDialog]() {
+        progressDialog->close();
+        progressDialog->deleteLater();
+
+        ImportReport report = importer->report();
+        importer->deleteLater();
+
+        QString reportText = QString("Прочитано строк: %1 за %2 с\n"
+                                     "Добавлено товаров: %3\n"
+                                     "Обновлено товаров: %4\n"
+                                     "Добавлено поставок: %5\n"
+                                     "Строк с ошибками: %6")
+                                 .arg(report.rowsRead)
+                                 .arg(report.elapsedMs / 1000.0, 0, 'f', 1)
+                                 .arg(report.productsInserted)
+                                 .arg(report.productsUpdated)
+                                 .arg(report.suppliesInserted)
+                                 .arg(report.errorCount);
+
+        if (!report.ok) {
+            reportText = report.errorString + "\n\n" + reportText;
+        }
+
+        QMessageBox messageBox(report.ok ? QMessageBox::Information : QMessageBox::Warning,
+                               "Импорт каталога", reportText, QMessageBox::Ok, this);
+
+        if (!report.errors.isEmpty()) {
+            QStringList lines;
+            for (const ImportRowError &error : report.errors) {
+                lines.append(QString("Строка %1: %2").arg(error.line).arg(error.message));
+            }
+            if (report.errorCount > report.errors.size()) {
+                lines.append(QString("... и еще %1").arg(report.errorCount - report.errors.size()));
+            }
+            messageBox.setDetailedText(lines.join("\n"));
+        }
+
+        messageBox.exec();
+
+        loadProductsData();
+        loadSuppliesData();
+    });
+
+    importer->start();
 }
 
 void AdminWindow::onFileSaveAs()
@@ -441,26 +559,329 @@ void AdminWindow::onFileSaveAs()
     QString fileName = QFileDialog::getSaveFileName(this, "Сохранить базу данных",
                                                     "", "SQLite Database (*.db);;All Files (*)");
 
-    if (!fileName.isEmpty())
-    {
+    if (fileName.isEmpty()) return;
 
-        if (QFile::exists("shop.db"))
-        {
-            if (QFile::copy("shop.db", fileName))
-            {
-                QMessageBox::information(this, "Успех",
-                                         QString("База данных сохранена в:\n%1").arg(fileName));
-            }
-            else
-            {
-                QMessageBox::warning(this, "Ошибка", "Не удалось сохранить базу данных");
+    if (!QFile::exists("shop.db")) {
+        QMessageBox::warning(this, "Ошибка", "Файл базы данных не найден");
+        return;
+    }
+
+    if (QFileInfo(fileName).absoluteFilePath() == QFileInfo("shop.db").absoluteFilePath()) {
+        QMessageBox::warning(this, "Ошибка", "Нельзя сохранить базу данных в саму себя");
+        return;
+    }
+
+    BackupWorker *worker = new BackupWorker("shop.db", fileName, this);
+
+    QProgressDialog *progressDialog = new QProgressDialog("Резервное копирование базы данных...",
+                                                          "Отмена", 0, 0, this);
+    progressDialog->setWindowModality(Qt::WindowModal);
+    progressDialog->setMinimumDuration(300);
+
+    connect(worker, &BackupWorker::progress, progressDialog, [progressDialog](int done, int total) {
+        progressDialog->setMaximum(total);
+        progressDialog->setValue(done);
+    });
+    connect(progressDialog, &QProgressDialog::canceled, worker, &QThread::requestInterruption);
+
+    connect(worker, &QThread::finished, this, [this, worker, progressDialog, fileName]() {
+        progressDialog->close();
+        progressDialog->deleteLater();
+
+        if (worker->succeeded()) {
+            QMessageBox::information(this, "Успех",
+                                     QString("База данных сохранена в:\n%1\nЗаписано: %2 КБ")
+                                         .arg(fileName)
+                                         .arg(worker->bytesWritten() / 1024));
+        } else {
+            QMessageBox::warning(this, "Ошибка",
+                                 QString("Не удалось сохранить базу данных\n%1").arg(worker->errorString()));
+        }
+
+        worker->deleteLater();
+    });
+
+    worker->start();
+}
+
+void AdminWindow::onFileArchiveSales()
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle("Архивирование продаж");
+    QFormLayout *form = new QFormLayout(&dialog);
+
+    QDateEdit *beforeDateEdit = new QDateEdit(QDate(QDate::currentDate().year(), 1, 1));
+    beforeDateEdit->setCalendarPopup(true);
+
+    form->addRow("Перенести продажи до:", beforeDateEdit);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    form->addRow(buttonBox);
+
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    Database db;
+    if (!db.connectToDatabase()) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось подключиться к БД");
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    int archived = db.archiveSales(beforeDateEdit->date());
+    QApplication::restoreOverrideCursor();
+
+    if (archived < 0) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось перенести продажи в архив");
+        return;
+    }
+
+    QMessageBox::information(this, "Архивирование продаж",
+                             QString("Перенесено в архив продаж: %1").arg(archived));
+    loadSalesData();
+}
+
+void AdminWindow::onFileExportSnapshot()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, "Снимок продаж", "продажи.hgsnap",
+                                                    "Снимок продаж (*.hgsnap);;All Files (*)");
+
+    if (fileName.isEmpty()) return;
+
+    bool compress = QMessageBox::question(this, "Снимок продаж",
+                                          "Сжимать данные снимка?\n"
+                                          "Файл будет меньше, но запись и чтение медленнее.")
+                    == QMessageBox::Yes;
+
+    Database db;
+    if (!db.connectToDatabase()) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось подключиться к БД");
+        return;
+    }
+
+    QString error;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    bool success = SalesSnapshot::write(db, fileName, compress, error);
+    QApplication::restoreOverrideCursor();
+
+    if (!success) {
+        QMessageBox::warning(this, "Ошибка", QString("Не удалось сохранить снимок\n%1").arg(error));
+        return;
+    }
+
+    QMessageBox::information(this, "Успех", QString("Снимок продаж сохранен в:\n%1").arg(fileName));
+}
+
+void AdminWindow::onFilePriceList()
+{
+    Database db;
+    if (!db.connectToDatabase()) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось подключиться к БД");
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Прайс-лист на период");
+    QFormLayout *form = new QFormLayout(&dialog);
+
+    QLineEdit *nameEdit = new QLineEdit("Распродажа");
+
+    QDateTimeEdit *fromEdit = new QDateTimeEdit(QDateTime(QDate::currentDate().addDays(1), QTime(0, 0)));
+    fromEdit->setCalendarPopup(true);
+    QDateTimeEdit *toEdit = new QDateTimeEdit(QDateTime(QDate::currentDate().addDays(8), QTime(0, 0)));
+    toEdit->setCalendarPopup(true);
+
+    QComboBox *categoryCombo = new QComboBox();
+    categoryCombo->addItem("Все категории", -1);
+    for (const ProductCategory &category : CategoryCache::instance().categories(db)) {
+        categoryCombo->addItem(category.name, category.id);
+    }
+
+    QDoubleSpinBox *percentSpin = new QDoubleSpinBox();
+    percentSpin->setRange(-100.0, 99.0);
+    percentSpin->setDecimals(2);
+    percentSpin->setSuffix(" %");
+    percentSpin->setValue(10.0);
+
+    form->addRow("Название:", nameEdit);
+    form->addRow("Действует с:", fromEdit);
+    form->addRow("Действует до:", toEdit);
+    form->addRow("Категория:", categoryCombo);
+    form->addRow("Скидка от розничной цены:", percentSpin);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    form->addRow(buttonBox);
+
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    QString name = nameEdit->text().trimmed();
+    if (name.isEmpty()) {
+        QMessageBox::warning(this, "Ошибка", "Укажите название прайс-листа");
+        return;
+    }
+
+    if (toEdit->dateTime() <= fromEdit->dateTime()) {
+        QMessageBox::warning(this, "Ошибка", "Конец периода должен быть позже начала");
+        return;
+    }
+
+    int categoryId = categoryCombo->currentData().toInt();
+    double percent = percentSpin->value();
+
+    QList<QPair<int, double>> prices;
+    for (const Product &product : db.getAllProducts()) {
+        if (categoryId == -1 || product.categoryId == categoryId) {
+            Money price = Money::fromDouble(product.retailPrice).discounted(percent);
+            prices.append(qMakePair(product.id, price.toDouble()));
+        }
+    }
+
+    if (prices.isEmpty()) {
+        QMessageBox::warning(this, "Ошибка", "Нет товаров для прайс-листа");
+        return;
+    }
+
+    int priceListId = db.addPriceList(name, fromEdit->dateTime(), toEdit->dateTime(), prices);
+    if (priceListId == -1) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось сохранить прайс-лист");
+        return;
+    }
+
+    QMessageBox::information(this, "Успех",
+                             QString("Прайс-лист \"%1\" сохранен\nТоваров: %2\nДействует: %3 - %4")
+                                 .arg(name)
+                                 .arg(prices.size())
+                                 .arg(fromEdit->dateTime().toString("dd.MM.yyyy HH:mm"))
+                                 .arg(toEdit->dateTime().toString("dd.MM.yyyy HH:mm")));
+}
+
+void AdminWindow::onFileExportReceipts()
+{
+    QDialog dialog(this);
+    dialog.setWindowTitle("Чеки за период");
+    QFormLayout *form = new QFormLayout(&dialog);
+
+    QDateEdit *startDateEdit = new QDateEdit(QDate::currentDate().addDays(-30));
+    startDateEdit->setCalendarPopup(true);
+    QDateEdit *endDateEdit = new QDateEdit(QDate::currentDate());
+    endDateEdit->setCalendarPopup(true);
+
+    QComboBox *cashierCombo = new QComboBox();
+    cashierCombo->addItem("Все кассиры", -1);
+    {
+        Database db;
+        if (db.connectToDatabase()) {
+            for (const User &user : db.getUsersByRole("Кассир")) {
+                cashierCombo->addItem(user.login, user.id);
             }
         }
-        else
-        {
-            QMessageBox::warning(this, "Ошибка", "Файл базы данных не найден");
+    }
+
+    QComboBox *modeCombo = new QComboBox();
+    modeCombo->addItem("Один файл", ReceiptBatchExporter::SingleFile);
+    modeCombo->addItem("Файл на каждый чек", ReceiptBatchExporter::FilePerReceipt);
+
+    form->addRow("Начальная дата:", startDateEdit);
+    form->addRow("Конечная дата:", endDateEdit);
+    form->addRow("Кассир:", cashierCombo);
+    form->addRow("Сохранить:", modeCombo);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    form->addRow(buttonBox);
+
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    auto mode = static_cast<ReceiptBatchExporter::Mode>(modeCombo->currentData().toInt());
+    QString targetPath;
+
+    if (mode == ReceiptBatchExporter::SingleFile) {
+        targetPath = QFileDialog::getSaveFileName(this, "Чеки за период", "чеки.pdf",
+                                                  "PDF (*.pdf);;All Files (*)");
+    } else {
+        targetPath = QFileDialog::getExistingDirectory(this, "Каталог для чеков");
+    }
+
+    if (targetPath.isEmpty()) return;
+
+    ReceiptBatchExporter *exporter = new ReceiptBatchExporter(startDateEdit->date(), endDateEdit->date(),
+                                                              cashierCombo->currentData().toInt(),
+                                                              mode, targetPath, this);
+
+    QProgressDialog *progressDialog = new QProgressDialog("Выгрузка чеков...", "Отмена", 0, 100, this);
+    progressDialog->setWindowModality(Qt::WindowModal);
+    progressDialog->setMinimumDuration(300);
+
+    connect(exporter, &ReceiptBatchExporter::progress, progressDialog, &QProgressDialog::setValue);
+    connect(progressDialog, &QProgressDialog::canceled, exporter, &QThread::requestInterruption);
+
+    connect(exporter, &QThread::finished, this, [this, exporter, progressDialog, targetPath]() {
+        progressDialog->close();
+        progressDialog->deleteLater();
+
+        if (exporter->succeeded()) {
+            QMessageBox::information(this, "Успех",
+                                     QString("Чеки сохранены в:\n%1\nЧеков: %2")
+                                         .arg(targetPath)
+                                         .arg(exporter->receiptsWritten()));
+        } else {
+            QMessageBox::warning(this, "Ошибка",
+                                 QString("Не удалось выгрузить чеки\n%1").arg(exporter->errorString()));
         }
+
+        exporter->deleteLater();
+    });
+
+    exporter->start();
+}
+
+void AdminWindow::onReportUseSnapshot(bool checked)
+{
+    snapshotPath.clear();
+
+    if (checked) {
+        snapshotPath = QFileDialog::getOpenFileName(this, "Отчеты по снимку", "",
+                                                    "Снимок продаж (*.hgsnap);;All Files (*)");
+    }
+
+    snapshotSourceAction->setChecked(!snapshotPath.isEmpty());
+}
+
+bool AdminWindow::generateProfitReport(const QDate &startDate, const QDate &endDate, ProfitReport &report)
+{
+    if (!snapshotPath.isEmpty()) {
+        SalesSnapshot snapshot(snapshotPath);
+
+        QApplication::setOverrideCursor(Qt::WaitCursor);
+        report = snapshot.generateProfitReport(startDate, endDate);
+        QApplication::restoreOverrideCursor();
+
+        if (snapshot.hasError()) {
+            QMessageBox::critical(this, "Ошибка", snapshot.errorString());
+            return false;
+        }
+        return true;
     }
+
+    Database db;
+    if (!db.connectToDatabase()) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось подключиться к БД");
+        return false;
+    }
+
+    report = db.generateProfitReport(startDate, endDate);
+    if (db.lastError().isValid()) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось построить отчет: " + db.lastError().text());
+        return false;
+    }
+    return true;
 }
 
 void AdminWindow::onReportProfit()
@@ -484,14 +905,11 @@ void AdminWindow::onReportProfit()
     connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
 
     if (dialog.exec() == QDialog::Accepted) {
-        Database db;
-        if (!db.connectToDatabase()) {
-            QMessageBox::critical(this, "Ошибка", "Не удалось подключиться к БД");
+        ProfitReport report;
+        if (!generateProfitReport(startDateEdit->date(), endDateEdit->date(), report)) {
             return;
         }
 
-        ProfitReport report = db.generateProfitReport(startDateEdit->date(), endDateEdit->date());
-
         QString reportText = QString(
                                  "Отчет о прибыли\n"
                                  "Период: %1 - %2\n\n"
@@ -504,6 +922,10 @@ void AdminWindow::onReportProfit()
                                  .arg(report.totalCost, 0, 'f', 2)
                                  .arg(report.totalProfit, 0, 'f', 2);
 
+        if (!snapshotPath.isEmpty()) {
+            reportText += QString("\n\nПо снимку: %1").arg(QFileInfo(snapshotPath).fileName());
+        }
+
         QMessageBox::information(this, "Отчет о прибыли", reportText);
     }
 }
@@ -529,14 +951,11 @@ void AdminWindow::onReportPopular()
     connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
 
     if (dialog.exec() == QDialog::Accepted) {
-        Database db;
-        if (!db.connectToDatabase()) {
-            QMessageBox::critical(this, "Ошибка", "Не удалось подключиться к БД");
+        ProfitReport report;
+        if (!generateProfitReport(startDateEdit->date(), endDateEdit->date(), report)) {
             return;
         }
 
-        ProfitReport report = db.generateProfitReport(startDateEdit->date(), endDateEdit->date());
-
         QString reportText = QString("Популярные товары\nПериод: %1 - %2\n\n")
                                  .arg(report.startDate.toString("dd.MM.yyyy"))
                                  .arg(report.endDate.toString("dd.MM.yyyy"));
@@ -552,10 +971,71 @@ void AdminWindow::onReportPopular()
             }
         }
 
+        if (!snapshotPath.isEmpty()) {
+            reportText += QString("\n\nПо снимку: %1").arg(QFileInfo(snapshotPath).fileName());
+        }
+
         QMessageBox::information(this, "Популярные товары", reportText);
     }
 }
 
+void AdminWindow::onReportReconcile()
+{
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    ReconciliationReport report = StockReconciler().run();
+    QApplication::restoreOverrideCursor();
+
+    if (!report.ok) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось выполнить сверку остатков");
+        return;
+    }
+
+    QString reportText = QString("Сверка остатков\n"
+                                 "Проверено товаров: %1 за %2 с\n"
+                                 "Расхождений: %3\n")
+                             .arg(report.productsChecked)
+                             .arg(report.elapsedMs / 1000.0, 0, 'f', 1)
+                             .arg(report.mismatches.size());
+
+    if (report.mismatches.isEmpty()) {
+        QMessageBox::information(this, "Сверка остатков", reportText);
+        return;
+    }
+
+    const int shown = qMin(report.mismatches.size(), 20);
+    reportText += "\n";
+    for (int i = 0; i < shown; i++) {
+        const StockMismatch &mismatch = report.mismatches[i];
+        reportText += QString("%1 - по журналу %2, ожидается %3\n")
+                          .arg(mismatch.productName)
+                          .arg(mismatch.ledgerStock)
+                          .arg(mismatch.expectedStock);
+    }
+    if (report.mismatches.size() > shown) {
+        reportText += QString("... и еще %1\n").arg(report.mismatches.size() - shown);
+    }
+    reportText += "\nИсправить остатки по поставкам и продажам?";
+
+    if (QMessageBox::question(this, "Сверка остатков", reportText) != QMessageBox::Yes) {
+        return;
+    }
+
+    QList<int> productIds;
+    for (const StockMismatch &mismatch : report.mismatches) {
+        productIds.append(mismatch.productId);
+    }
+
+    Database db;
+    int repaired = db.connectToDatabase() ? db.reconcileStock(productIds) : -1;
+    if (repaired < 0) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось исправить остатки");
+        return;
+    }
+
+    QMessageBox::information(this, "Сверка остатков", QString("Исправлено товаров: %1").arg(repaired));
+    loadProductsData();
+}
+
 void AdminWindow::onHelpAbout()
 {
     QMessageBox::about(this, "О программе",
@@ -652,6 +1132,166 @@ void AdminWindow::onDeleteProduct()
     }
 }
 
+void AdminWindow::onBulkChangePrices()
+{
+    Database db;
+    if (!db.connectToDatabase()) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось подключиться к базе данных");
+        return;
+    }
+
+    QList<int> selectedIds = selectedProductIds();
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Изменение цен");
+    QFormLayout *form = new QFormLayout(&dialog);
+
+    QCheckBox *selectedCheck = new QCheckBox(QString("Только выделенные (%1)").arg(selectedIds.size()));
+    selectedCheck->setChecked(selectedIds.size() > 1);
+    selectedCheck->setEnabled(!selectedIds.isEmpty());
+
+    QComboBox *categoryCombo = new QComboBox();
+    categoryCombo->addItem("Все категории", -1);
+    categoryCombo->addItem("Без категории", 0);
+    for (const ProductCategory &category : CategoryCache::instance().categories(db)) {
+        categoryCombo->addItem(category.name, category.id);
+    }
+
+    QLineEdit *textEdit = new QLineEdit();
+    textEdit->setPlaceholderText("Название или артикул содержит");
+
+    QComboBox *columnCombo = new QComboBox();
+    columnCombo->addItem("Розничная цена", Database::RetailPrice);
+    columnCombo->addItem("Закупочная цена", Database::PurchasePrice);
+
+    QComboBox *changeCombo = new QComboBox();
+    changeCombo->addItem("На процент", Database::ChangePercent);
+    changeCombo->addItem("На сумму", Database::ChangeAmount);
+
+    QDoubleSpinBox *valueSpin = new QDoubleSpinBox();
+    valueSpin->setDecimals(2);
+    valueSpin->setRange(-100.0, 1000.0);
+    valueSpin->setSuffix(" %");
+    valueSpin->setValue(5.0);
+
+    connect(changeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), valueSpin, [changeCombo, valueSpin]() {
+        if (changeCombo->currentData().toInt() == Database::ChangePercent) {
+            valueSpin->setRange(-100.0, 1000.0);
+            valueSpin->setSuffix(" %");
+        } else {
+            valueSpin->setRange(-1000000.0, 1000000.0);
+            valueSpin->setSuffix(" руб.");
+        }
+    });
+
+    form->addRow(selectedCheck);
+    form->addRow("Категория:", categoryCombo);
+    form->addRow("Фильтр:", textEdit);
+    form->addRow("Цена:", columnCombo);
+    form->addRow("Изменить:", changeCombo);
+    form->addRow("Значение:", valueSpin);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    form->addRow(buttonBox);
+
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    if (qFuzzyIsNull(valueSpin->value())) return;
+
+    ProductFilter filter;
+    filter.categoryId = categoryCombo->currentData().toInt();
+    filter.text = textEdit->text().trimmed();
+    if (selectedCheck->isChecked()) {
+        filter.productIds = selectedIds;
+    }
+
+    if (!confirmBulkUpdate(db, filter, "Изменить цены")) return;
+
+    int changed = db.bulkChangePrice(filter,
+                                     static_cast<Database::PriceColumn>(columnCombo->currentData().toInt()),
+                                     static_cast<Database::PriceChange>(changeCombo->currentData().toInt()),
+                                     valueSpin->value());
+    if (changed == -1) {
+        QMessageBox::warning(this, "Ошибка", "Не удалось изменить цены");
+        return;
+    }
+
+    loadProductsData();
+    QMessageBox::information(this, "Успех", QString("Цены изменены у товаров: %1").arg(changed));
+}
+
+void AdminWindow::onBulkMoveCategory()
+{
+    QList<int> selectedIds = selectedProductIds();
+    if (selectedIds.isEmpty()) return;
+
+    Database db;
+    if (!db.connectToDatabase()) {
+        QMessageBox::critical(this, "Ошибка", "Не удалось подключиться к базе данных");
+        return;
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Смена категории");
+    QFormLayout *form = new QFormLayout(&dialog);
+
+    QComboBox *categoryCombo = new QComboBox();
+    categoryCombo->addItem("Без категории", 0);
+    for (const ProductCategory &category : CategoryCache::instance().categories(db)) {
+        categoryCombo->addItem(category.name, category.id);
+    }
+
+    form->addRow(new QLabel(QString("Выделено товаров: %1").arg(selectedIds.size())));
+    form->addRow("Новая категория:", categoryCombo);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    form->addRow(buttonBox);
+
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    if (dialog.exec() != QDialog::Accepted) return;
+
+    ProductFilter filter;
+    filter.productIds = selectedIds;
+
+    QString action = QString("Перенести в категорию \"%1\"").arg(categoryCombo->currentText());
+    if (!confirmBulkUpdate(db, filter, action)) return;
+
+    int moved = db.bulkMoveCategory(filter, categoryCombo->currentData().toInt());
+    if (moved == -1) {
+        QMessageBox::warning(this, "Ошибка", "Не удалось сменить категорию");
+        return;
+    }
+
+    loadProductsData();
+    QMessageBox::information(this, "Успех", QString("Перенесено товаров: %1").arg(moved));
+}
+
+bool AdminWindow::confirmBulkUpdate(Database &db, const ProductFilter &filter, const QString &action)
+{
+    int count = db.countProducts(filter);
+    if (count == -1) {
+        QMessageBox::warning(this, "Ошибка", "Не удалось подсчитать товары");
+        return false;
+    }
+
+    if (count == 0) {
+        QMessageBox::information(this, "Нет товаров", "Под условия не попал ни один товар");
+        return false;
+    }
+
+    QMessageBox::StandardButton reply = QMessageBox::question(this, "Подтверждение",
+                                                              QString("%1\nБудет изменено товаров: %2. Продолжить?")
+                                                                  .arg(action)
+                                                                  .arg(count),
+                                                              QMessageBox::Yes | QMessageBox::No);
+    return reply == QMessageBox::Yes;
+}
+
 void AdminWindow::onAddSupply()
 {
     showAddSupplyForm();
@@ -704,28 +1344,17 @@ void AdminWindow::onDeleteSupply()
 
 void AdminWindow::onExportTable()
 {
-    QTableWidget *currentTable = nullptr;
-    QString defaultName;
-
     if (ui->rbProduct->isChecked())
     {
-        currentTable = productsTable;
-        defaultName = "товары.csv";
+        exportTableToCSV(Database::ExportProducts, "товары.csv");
     }
     else if (ui->rbSupply->isChecked())
     {
-        currentTable = suppliesTable;
-        defaultName = "поставки.csv";
+        exportTableToCSV(Database::ExportSupplies, "поставки.csv");
     }
     else if (ui->rbSale->isChecked())
     {
-        currentTable = salesTable;
-        defaultName = "продажи.csv";
-    }
-
-    if (currentTable)
-    {
-        saveTableToCSV(currentTable);
+        exportTableToCSV(Database::ExportSales, "продажи.csv");
     }
 }
 
@@ -739,10 +1368,11 @@ void AdminWindow::onTableSelectionChanged()
         hasSelection = !productsTable->selectedItems().isEmpty();
 
         QList<QAction *> actions = productsToolBar->actions();
-        if (actions.size() >= 3)
+        if (actions.size() >= 6)
         {
             actions[1]->setEnabled(hasSelection);
             actions[2]->setEnabled(hasSelection);
+            actions[5]->setEnabled(hasSelection);
         }
     }
     else if (ui->rbSupply->isChecked())
@@ -771,89 +1401,52 @@ void AdminWindow::on_pbAdminAccount_clicked()
     }
 }
 
-QString AdminWindow::tableToCSV(QTableWidget *table)
+void AdminWindow::exportTableToCSV(Database::ExportTable table, const QString &defaultName)
 {
-    QString csv;
-    QTextStream stream(&csv);
-
-    for (int i = 0; i < table->columnCount(); i++)
-    {
-        if (!table->isColumnHidden(i))
-        {
-            stream << "\"" << table->horizontalHeaderItem(i)->text() << "\"";
-            if (i < table->columnCount() - 1)
-            {
-                stream << ";";
-            }
-        }
-    }
-    stream << "\n";
-
-    for (int row = 0; row < table->rowCount(); row++)
-    {
-        for (int col = 0; col < table->columnCount(); col++)
-        {
-            if (!table->isColumnHidden(col))
-            {
-                QTableWidgetItem *item = table->item(row, col);
-                if (item && !item->text().isEmpty())
-                {
-                    stream << "\"" << item->text() << "\"";
-                }
-                else
-                {
-                    stream << "\"\"";
-                }
-
-                if (col < table->columnCount() - 1)
-                {
-                    stream << ";";
-                }
-            }
-        }
-        stream << "\n";
-    }
+    QString fileName = QFileDialog::getSaveFileName(this, "Экспорт таблицы",
+                                                    defaultName, "CSV Files (*.csv);;All Files (*)");
 
-    return csv;
-}
+    if (fileName.isEmpty()) return;
 
-void AdminWindow::saveTableToCSV(QTableWidget *table)
-{
-    QString defaultName;
-    if (ui->rbProduct->isChecked())
-    {
-        defaultName = "товары.csv";
-    }
-    else if (ui->rbSupply->isChecked())
-    {
-        defaultName = "поставки.csv";
-    }
-    else if (ui->rbSale->isChecked())
-    {
-        defaultName = "продажи.csv";
-    }
+    CsvExporter *exporter = new CsvExporter("shop.db", table, fileName, this);
 
-    QString fileName = QFileDialog::getSaveFileName(this, "Экспорт таблицы",
-                                                    defaultName, "CSV Files (*.csv);;All Files (*)");
+    QProgressDialog *progressDialog = new QProgressDialog("Экспорт таблицы...", "Отмена", 0, 100, this);
+    progressDialog->setWindowModality(Qt::WindowModal);
+    progressDialog->setMinimumDuration(300);
 
-    if (!fileName.isEmpty())
-    {
-        QFile file(fileName);
-        if (file.open(QIODevice::WriteOnly | QIODevice::Text))
-        {
-            QTextStream stream(&file);
+    connect(exporter, &CsvExporter::progress, progressDialog, &QProgressDialog::setValue);
+    connect(progressDialog, &QProgressDialog::canceled, exporter, &QThread::requestInterruption);
 
-            stream << tableToCSV(table);
-            file.close();
+    connect(exporter, &QThread::finished, this, [this, exporter, progressDialog, fileName]() {
+        progressDialog->close();
+        progressDialog->deleteLater();
 
+        if (exporter->succeeded()) {
             QMessageBox::information(this, "Успех",
-                                     QString("Таблица успешно экспортирована в:\n%1").arg(fileName));
+                                     QString("Таблица успешно экспортирована в:\n%1\nСтрок: %2")
+                                         .arg(fileName)
+                                         .arg(exporter->rowsWritten()));
+        } else {
+            QMessageBox::warning(this, "Ошибка",
+                                 QString("Не удалось сохранить файл\n%1").arg(exporter->errorString()));
         }
-        else
-        {
-            QMessageBox::warning(this, "Ошибка", "Не удалось сохранить файл");
+
+        exporter->deleteLater();
+    });
+
+    exporter->start();
+}
+
+QList<int> AdminWindow::selectedProductIds() const
+{
+    QList<int> ids;
+    for (const QModelIndex &index : productsTable->selectionModel()->selectedRows(0)) {
+        QTableWidgetItem *idItem = productsTable->item(index.row(), 0);
+        if (idItem) {
+            ids.append(idItem->text().toInt());
         }
     }
+    return ids;
 }
 
 int AdminWindow::getSelectedRowId(QTableWidget *table, int column)
@@ -29,10 +29,16 @@ public:
 
 private slots:
     void onFileOpen();
+    void onFilePriceList();
     void onFileSaveAs();
+    void onFileArchiveSales();
+    void onFileExportSnapshot();
+    void onFileExportReceipts();
 
     void onReportProfit();
     void onReportPopular();
+    void onReportReconcile();
+    void onReportUseSnapshot(bool checked);
 
     void onHelpAbout();
     void onHelpReference();
@@ -42,6 +48,8 @@ private slots:
     void onAddProduct();
     void onEditProduct();
     void onDeleteProduct();
+    void onBulkChangePrices();
+    void onBulkMoveCategory();
     void onAddSupply();
     void onDeleteSupply();
     void onExportTable();
@@ -80,6 +88,9 @@ private:
 
     QAction *profitReportAction;
     QAction *popularReportAction;
+    QAction *snapshotSourceAction;
+
+    QString snapshotPath;
 
     void setupMenuBar();
     void setupPages();
@@ -105,10 +116,13 @@ private:
     void updateSuppliesTable(const QList<Supply> &supplies);
     void updateSalesTable(const QList<Sale> &sales);
 
-    QString tableToCSV(QTableWidget *table);
-    void saveTableToCSV(QTableWidget *table);
+    bool generateProfitReport(const QDate &startDate, const QDate &endDate, ProfitReport &report);
+
+    void exportTableToCSV(Database::ExportTable table, const QString &defaultName);
 
     int getSelectedRowId(QTableWidget *table, int column = 0);
+    QList<int> selectedProductIds() const;
+    bool confirmBulkUpdate(Database &db, const ProductFilter &filter, const QString &action);
 };
 
 #endif // ADMINWINDOW_H
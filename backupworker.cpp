@@ -0,0 +1,121 @@
+#include "backupworker.h"
+#include <QAtomicInt>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QTemporaryFile>
+
+// Файл снимка переносится в копию порциями, между ними проверяется отмена
+static const qint64 COPY_CHUNK_BYTES = 1024 * 1024;
+static const int BUSY_TIMEOUT_MS = 1000;
+
+static QAtomicInt backupCounter;
+
+BackupWorker::BackupWorker(const QString &sourcePath, const QString &targetPath, QObject *parent)
+    : QThread(parent)
+    , sourcePath(sourcePath)
+    , targetPath(targetPath)
+    , success(false)
+    , writtenBytes(0)
+{
+}
+
+void BackupWorker::run()
+{
+    success = false;
+    writtenBytes = 0;
+
+    // Временный файл в каталоге копии: оттуда QSaveFile подменяет копию переименованием
+    QFileInfo target(targetPath);
+    QTemporaryFile snapshot(target.absoluteDir().filePath(target.fileName() + ".XXXXXX.part"));
+    if (!snapshot.open()) {
+        error = "Не удалось создать временный файл: " + snapshot.errorString();
+        return;
+    }
+    snapshot.close();
+
+    success = createSnapshot(snapshot.fileName()) && replaceTarget(snapshot.fileName());
+}
+
+bool BackupWorker::createSnapshot(const QString &snapshotPath)
+{
+    QString connectionName = QString("backup_%1").arg(backupCounter.fetchAndAddRelaxed(1));
+    bool ok = false;
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(sourcePath);
+        db.setConnectOptions(QString("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=%1").arg(BUSY_TIMEOUT_MS));
+
+        if (!db.open()) {
+            error = "Не удалось открыть базу данных: " + db.lastError().text();
+        } else {
+            // Согласованный снимок за один проход чтения тем же SQLite, что у драйвера
+            QSqlQuery query(db);
+            query.prepare("VACUUM INTO :path");
+            query.bindValue(":path", snapshotPath);
+
+            ok = query.exec();
+            if (!ok) {
+                error = "Ошибка резервного копирования: " + query.lastError().text();
+            }
+        }
+
+        db.close();
+    }
+
+    QSqlDatabase::removeDatabase(connectionName);
+
+    if (ok && isInterruptionRequested()) {
+        error = "Копирование отменено";
+        return false;
+    }
+    return ok;
+}
+
+bool BackupWorker::replaceTarget(const QString &snapshotPath)
+{
+    QFile snapshot(snapshotPath);
+    if (!snapshot.open(QIODevice::ReadOnly)) {
+        error = "Не удалось прочитать снимок базы данных: " + snapshot.errorString();
+        return false;
+    }
+
+    // Прежняя копия заменяется только после commit(); до этого она не тронута
+    QSaveFile target(targetPath);
+    if (!target.open(QIODevice::WriteOnly)) {
+        error = "Не удалось открыть файл резервной копии: " + target.errorString();
+        return false;
+    }
+
+    const qint64 total = snapshot.size();
+    QByteArray chunk;
+
+    while (!snapshot.atEnd()) {
+        if (isInterruptionRequested()) {
+            target.cancelWriting();
+            error = "Копирование отменено";
+            return false;
+        }
+
+        chunk = snapshot.read(COPY_CHUNK_BYTES);
+        if (chunk.isEmpty() || target.write(chunk) != chunk.size()) {
+            target.cancelWriting();
+            error = "Ошибка записи резервной копии: " + target.errorString();
+            return false;
+        }
+
+        writtenBytes += chunk.size();
+        emit progress(static_cast<int>(writtenBytes * 100 / qMax<qint64>(total, 1)), 100);
+    }
+
+    if (!target.commit()) {
+        error = "Ошибка записи резервной копии: " + target.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,40 @@
+#ifndef BACKUPWORKER_H
+#define BACKUPWORKER_H
+
+#include <QThread>
+#include <QString>
+
+// Резервное копирование работающей базы в фоновом потоке.
+// Снимок снимается через VACUUM INTO на собственном соединении драйвера QSQLITE
+// во временный файл рядом с копией, затем атомарно заменяет прежнюю копию:
+// отмена или сбой посреди прохода оставляют последнюю удачную копию целой.
+class BackupWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    BackupWorker(const QString &sourcePath, const QString &targetPath, QObject *parent = nullptr);
+
+    bool succeeded() const { return success; }
+    QString errorString() const { return error; }
+    qint64 bytesWritten() const { return writtenBytes; }
+
+signals:
+    void progress(int done, int total);
+
+protected:
+    void run() override;
+
+private:
+    QString sourcePath;
+    QString targetPath;
+
+    bool success;
+    QString error;
+    qint64 writtenBytes;
+
+    bool createSnapshot(const QString &snapshotPath);
+    bool replaceTarget(const QString &snapshotPath);
+};
+
+#endif // BACKUPWORKER_H
@@ -0,0 +1,15 @@
+QT += core sql testlib
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = databasebenchmark
+
+include(../database.pri)
+
+SOURCES += \
+    databasebenchmark.cpp
+
+RESOURCES += \
+    ../resources.qrc
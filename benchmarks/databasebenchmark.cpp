@@ -0,0 +1,453 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "database.h"
+#include "money.h"
+
+// Размер тестовой базы и путь к отчету задаются переменными окружения:
+//   HGS_BENCH_PRODUCTS        - количество товаров (по умолчанию 1000)
+//   HGS_BENCH_SALES           - количество продаж (по умолчанию 5000)
+//   HGS_BENCH_ITEMS_PER_SALE  - максимум позиций в чеке (по умолчанию 5)
+//   HGS_BENCH_SEED            - зерно генератора (по умолчанию 42)
+//   HGS_BENCH_LINES           - строк в корзине для сравнения сумм (по умолчанию 1000)
+//   HGS_BENCH_JSON            - файл с результатами (по умолчанию benchmark_results.json)
+
+struct BenchmarkResult {
+    qint64 passes = 0;
+    qint64 iterations = 0;
+    qint64 elapsedNs = 0;
+};
+
+static int envInt(const char *name, int defaultValue)
+{
+    bool ok = false;
+    int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok && value > 0 ? value : defaultValue;
+}
+
+class BenchmarkProbe
+{
+public:
+    BenchmarkProbe(QMap<QString, BenchmarkResult> &results, const QString &name)
+        : results(results), name(name), iterations(0)
+    {
+        timer.start();
+    }
+
+    ~BenchmarkProbe()
+    {
+        // QTest может прогонять QBENCHMARK несколько раз, подбирая число итераций.
+        // Счетчики складываются по всем проходам, включая прогревочные, поэтому
+        // в отчете среднее время итерации по ним, а не результат QTest за последний проход
+        BenchmarkResult &result = results[name];
+        result.passes++;
+        result.iterations += iterations;
+        result.elapsedNs += timer.nsecsElapsed();
+    }
+
+    void tick() { ++iterations; }
+
+private:
+    QMap<QString, BenchmarkResult> &results;
+    QString name;
+    qint64 iterations;
+    QElapsedTimer timer;
+};
+
+class DatabaseBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void cleanup();
+
+    void getAllProducts();
+    void getAllSales();
+    void createSale();
+    void addToCart();
+    void createSaleForClient();
+    void generateProfitReport();
+    void authenticateUser();
+
+    void lineTotalsDouble();
+    void lineTotalsMoney();
+
+private:
+    QTemporaryDir workDir;
+    QString originalDir;
+    Database db;
+
+    int productCount = 0;
+    int saleCount = 0;
+    int itemsPerSale = 0;
+    quint32 seed = 0;
+
+    int cashierId = -1;
+    int clientId = -1;
+    QList<int> productIds;
+
+    // Одна и та же корзина в рублях и в копейках
+    QVector<double> linePrices;
+    QVector<qint64> lineMinorPrices;
+    QVector<qint32> lineQuantities;
+    QVector<qint64> lineTotals;
+
+    QMap<QString, BenchmarkResult> results;
+
+    bool seedDatabase();
+    QList<SaleItem> randomSaleItems(QRandomGenerator &random);
+    void prepareLines(int count);
+    void writeResults();
+};
+
+void DatabaseBenchmark::initTestCase()
+{
+    productCount = envInt("HGS_BENCH_PRODUCTS", 1000);
+    saleCount = envInt("HGS_BENCH_SALES", 5000);
+    itemsPerSale = envInt("HGS_BENCH_ITEMS_PER_SALE", 5);
+    seed = static_cast<quint32>(envInt("HGS_BENCH_SEED", 42));
+
+    QVERIFY(workDir.isValid());
+    originalDir = QDir::currentPath();
+    QDir::setCurrent(workDir.path());
+
+    QVERIFY(db.initializeDatabase());
+    QVERIFY(db.connectToDatabase());
+    QVERIFY(seedDatabase());
+    QVERIFY(db.createStockSnapshots());
+
+    prepareLines(envInt("HGS_BENCH_LINES", 1000));
+}
+
+void DatabaseBenchmark::cleanupTestCase()
+{
+    writeResults();
+    QDir::setCurrent(originalDir);
+}
+
+void DatabaseBenchmark::cleanup()
+{
+    db.clearCart(clientId);
+}
+
+bool DatabaseBenchmark::seedDatabase()
+{
+    QSqlDatabase seedDb = QSqlDatabase::addDatabase("QSQLITE", "bench_seed");
+    seedDb.setDatabaseName("shop.db");
+    if (!seedDb.open()) {
+        qWarning() << "Не удалось открыть базу для заполнения:" << seedDb.lastError().text();
+        return false;
+    }
+
+    bool ok = true;
+    {
+        QSqlQuery query(seedDb);
+        QRandomGenerator random(seed);
+
+        query.exec("SELECT id, role FROM users");
+        while (query.next()) {
+            if (query.value(1).toString() == "Кассир" && cashierId == -1) {
+                cashierId = query.value(0).toInt();
+            } else if (query.value(1).toString() == "Клиент" && clientId == -1) {
+                clientId = query.value(0).toInt();
+            }
+        }
+
+        QList<int> categoryIds;
+        query.exec("SELECT id FROM product_categories");
+        while (query.next()) {
+            categoryIds.append(query.value(0).toInt());
+        }
+
+        seedDb.transaction();
+
+        query.prepare("INSERT INTO products (article, name, category_id, purchase_price, retail_price) "
+                      "VALUES (:article, :name, :category_id, :purchase_price, :retail_price)");
+
+        QSqlQuery stockQuery(seedDb);
+        stockQuery.prepare("INSERT INTO stock_movements (product_id, quantity, reason) "
+                           "VALUES (:product_id, 1000000000, 'initial')");
+        for (int i = 1; i <= productCount && ok; i++) {
+            double purchasePrice = 10 + random.bounded(49000) / 100.0;
+            query.bindValue(":article", QString("BENCH-%1").arg(i, 7, 10, QChar('0')));
+            query.bindValue(":name", QString("Товар %1").arg(i, 7, 10, QChar('0')));
+            query.bindValue(":category_id", categoryIds.isEmpty()
+                                                ? QVariant()
+                                                : categoryIds[random.bounded(categoryIds.size())]);
+            query.bindValue(":purchase_price", purchasePrice);
+            query.bindValue(":retail_price", qRound(purchasePrice * 130) / 100.0);
+            ok = query.exec();
+            productIds.append(query.lastInsertId().toInt());
+
+            stockQuery.bindValue(":product_id", productIds.last());
+            ok = ok && stockQuery.exec();
+        }
+
+        QSqlQuery saleQuery(seedDb);
+        saleQuery.prepare("INSERT INTO sales (receipt_number, sale_date, cashier_id, customer_id, "
+                          "total_amount, discount_amount) "
+                          "VALUES (:receipt_number, :sale_date, :cashier_id, :customer_id, "
+                          ":total_amount, 0)");
+
+        QSqlQuery itemQuery(seedDb);
+        itemQuery.prepare("INSERT INTO sale_items (sale_id, product_id, quantity, retail_price, total_price) "
+                          "VALUES (:sale_id, :product_id, :quantity, :retail_price, :total_price)");
+
+        QDateTime now = QDateTime::currentDateTime();
+        for (int i = 1; i <= saleCount && ok; i++) {
+            QList<SaleItem> items = randomSaleItems(random);
+            double total = 0;
+            for (const SaleItem &item : items) {
+                total += item.totalPrice;
+            }
+
+            bool byClient = random.bounded(4) == 0;
+            saleQuery.bindValue(":receipt_number", QString("BENCH%1").arg(i, 10, 10, QChar('0')));
+            saleQuery.bindValue(":sale_date", now.addSecs(-static_cast<qint64>(random.bounded(365 * 24 * 3600))));
+            saleQuery.bindValue(":cashier_id", byClient ? QVariant() : cashierId);
+            saleQuery.bindValue(":customer_id", byClient ? clientId : QVariant());
+            saleQuery.bindValue(":total_amount", total);
+            ok = saleQuery.exec();
+
+            int saleId = saleQuery.lastInsertId().toInt();
+            for (const SaleItem &item : items) {
+                itemQuery.bindValue(":sale_id", saleId);
+                itemQuery.bindValue(":product_id", item.productId);
+                itemQuery.bindValue(":quantity", item.quantity);
+                itemQuery.bindValue(":retail_price", item.retailPrice);
+                itemQuery.bindValue(":total_price", item.totalPrice);
+                ok = ok && itemQuery.exec();
+            }
+        }
+
+        if (ok) {
+            seedDb.commit();
+        } else {
+            qWarning() << "Ошибка заполнения базы:" << query.lastError().text()
+                       << saleQuery.lastError().text() << itemQuery.lastError().text();
+            seedDb.rollback();
+        }
+    }
+
+    seedDb.close();
+    seedDb = QSqlDatabase();
+    QSqlDatabase::removeDatabase("bench_seed");
+
+    return ok && cashierId != -1 && clientId != -1;
+}
+
+QList<SaleItem> DatabaseBenchmark::randomSaleItems(QRandomGenerator &random)
+{
+    QList<SaleItem> items;
+    int count = 1 + random.bounded(itemsPerSale);
+
+    for (int i = 0; i < count; i++) {
+        SaleItem item;
+        item.productId = productIds[random.bounded(productIds.size())];
+        item.quantity = 1 + random.bounded(3);
+        item.retailPrice = 10 + random.bounded(60000) / 100.0;
+        item.totalPrice = item.retailPrice * item.quantity;
+        items.append(item);
+    }
+
+    return items;
+}
+
+void DatabaseBenchmark::prepareLines(int count)
+{
+    QRandomGenerator random(seed);
+
+    linePrices.resize(count);
+    lineMinorPrices.resize(count);
+    lineQuantities.resize(count);
+    lineTotals.resize(count);
+
+    for (int i = 0; i < count; i++) {
+        lineMinorPrices[i] = 1000 + random.bounded(60000);
+        linePrices[i] = lineMinorPrices[i] / 100.0;
+        lineQuantities[i] = 1 + random.bounded(5);
+    }
+}
+
+void DatabaseBenchmark::getAllProducts()
+{
+    BenchmarkProbe probe(results, QTest::currentTestFunction());
+    QBENCHMARK {
+        probe.tick();
+        QList<Product> products = db.getAllProducts();
+        QVERIFY(products.size() >= productCount);
+    }
+}
+
+void DatabaseBenchmark::getAllSales()
+{
+    BenchmarkProbe probe(results, QTest::currentTestFunction());
+    QBENCHMARK {
+        probe.tick();
+        QList<Sale> sales = db.getAllSales();
+        QVERIFY(sales.size() >= saleCount);
+    }
+}
+
+void DatabaseBenchmark::createSale()
+{
+    QRandomGenerator random(seed);
+
+    BenchmarkProbe probe(results, QTest::currentTestFunction());
+    QBENCHMARK {
+        probe.tick();
+        QList<SaleItem> items = randomSaleItems(random);
+
+        Sale sale;
+        sale.cashierId = cashierId;
+        sale.customerId = -1;
+        sale.totalAmount = 0;
+        for (const SaleItem &item : items) {
+            sale.totalAmount += item.totalPrice;
+        }
+        sale.discountAmount = 0;
+        sale.finalAmount = sale.totalAmount;
+
+        QVERIFY(db.createSale(sale, items) != -1);
+    }
+}
+
+void DatabaseBenchmark::addToCart()
+{
+    QRandomGenerator random(seed);
+
+    BenchmarkProbe probe(results, QTest::currentTestFunction());
+    QBENCHMARK {
+        probe.tick();
+        QVERIFY(db.addToCart(clientId, productIds[random.bounded(productIds.size())], 1));
+    }
+}
+
+void DatabaseBenchmark::createSaleForClient()
+{
+    QRandomGenerator random(seed);
+
+    // Каждая итерация сначала наполняет корзину: без нее продажа не создается.
+    // Стоимость самого addToCart измеряется отдельным бенчмарком.
+    BenchmarkProbe probe(results, QTest::currentTestFunction());
+    QBENCHMARK {
+        probe.tick();
+        for (int i = 0; i < 3; i++) {
+            db.addToCart(clientId, productIds[random.bounded(productIds.size())], 1);
+        }
+
+        Sale sale;
+        sale.customerId = clientId;
+        sale.discountAmount = 0;
+        QVERIFY(db.createSaleForClient(sale));
+    }
+}
+
+void DatabaseBenchmark::generateProfitReport()
+{
+    QDate endDate = QDate::currentDate();
+    QDate startDate = endDate.addYears(-1);
+
+    BenchmarkProbe probe(results, QTest::currentTestFunction());
+    QBENCHMARK {
+        probe.tick();
+        ProfitReport report = db.generateProfitReport(startDate, endDate);
+        QVERIFY(report.totalRevenue > 0);
+    }
+}
+
+void DatabaseBenchmark::authenticateUser()
+{
+    BenchmarkProbe probe(results, QTest::currentTestFunction());
+    QBENCHMARK {
+        probe.tick();
+        User user = db.authenticateUser("admin", "admin123");
+        QVERIFY(user.id != -1);
+    }
+}
+
+// Прежний расчет корзины: сумма строк в double
+void DatabaseBenchmark::lineTotalsDouble()
+{
+    const int count = linePrices.size();
+    const double *prices = linePrices.constData();
+    const qint32 *quantities = lineQuantities.constData();
+    double total = 0;
+
+    BenchmarkProbe probe(results, QTest::currentTestFunction());
+    QBENCHMARK {
+        probe.tick();
+        total = 0;
+        for (int i = 0; i < count; i++) {
+            total += prices[i] * quantities[i];
+        }
+    }
+
+    QVERIFY(total > 0);
+}
+
+// Ядра Money, через которые PromotionEngine::evaluate считает подытог
+void DatabaseBenchmark::lineTotalsMoney()
+{
+    const int count = lineMinorPrices.size();
+    Money total;
+
+    BenchmarkProbe probe(results, QTest::currentTestFunction());
+    QBENCHMARK {
+        probe.tick();
+        Money::lineTotals(lineMinorPrices.constData(), lineQuantities.constData(), lineTotals.data(), count);
+        total = Money::sum(lineTotals.constData(), count);
+    }
+
+    QVERIFY(total > Money());
+}
+
+void DatabaseBenchmark::writeResults()
+{
+    QJsonObject dataset;
+    dataset["products"] = productCount;
+    dataset["sales"] = saleCount;
+    dataset["itemsPerSale"] = itemsPerSale;
+    dataset["seed"] = static_cast<qint64>(seed);
+
+    QJsonArray benchmarks;
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        QJsonObject entry;
+        entry["name"] = it.key();
+        entry["passes"] = it.value().passes;
+        entry["iterations"] = it.value().iterations;
+        entry["totalNs"] = it.value().elapsedNs;
+        entry["nsPerIteration"] = it.value().iterations > 0
+                                      ? static_cast<double>(it.value().elapsedNs) / it.value().iterations
+                                      : 0.0;
+        benchmarks.append(entry);
+    }
+
+    QJsonObject root;
+    root["suite"] = "DatabaseBenchmark";
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["qtVersion"] = qVersion();
+    root["dataset"] = dataset;
+    root["results"] = benchmarks;
+
+    QString fileName = qEnvironmentVariable("HGS_BENCH_JSON", "benchmark_results.json");
+    QFile file(QDir(originalDir).absoluteFilePath(fileName));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Не удалось записать результаты:" << file.fileName();
+        return;
+    }
+
+    file.write(QJsonDocument(root).toJson());
+    qDebug() << "Результаты сохранены в" << file.fileName();
+}
+
+QTEST_GUILESS_MAIN(DatabaseBenchmark)
+
+#include "databasebenchmark.moc"
@@ -2,9 +2,16 @@
 #include "ui_cashierwindow.h"
 #include "authwindow.h"
 #include "salesreceiptform.h"
+#include "printspooler.h"
+#include "promotionengine.h"
 #include <QMessageBox>
 #include <QPushButton>
 #include <QHeaderView>
+#include <QVector>
+
+static const int PriceRole = Qt::UserRole;
+static const int ProductIdRole = Qt::UserRole + 1;
+static const int CategoryIdRole = Qt::UserRole + 2;
 
 CashierWindow::CashierWindow(QWidget *parent) :
     QWidget(parent),
@@ -62,6 +69,13 @@ CashierWindow::CashierWindow(QWidget *parent) :
         }
     });
 
+    connect(&PrintSpooler::instance(), &PrintSpooler::jobFinished, this,
+            [this](qint64, bool success, const QString &error) {
+        if (!success) {
+            QMessageBox::warning(this, "Ошибка печати", "Чек не напечатан: " + error);
+        }
+    });
+
     loadProducts();
 }
 
@@ -98,7 +112,8 @@ void CashierWindow::loadProducts()
         return;
     }
 
-    auto products = db.getAllProducts();
+    // Только товары в наличии, цены уже с учетом действующих прайс-листов
+    auto products = db.getProductsForCashier();
 
     for (const auto &product : products) {
         int row = ui->twProducts->rowCount();
@@ -114,7 +129,7 @@ void CashierWindow::loadProducts()
         Product productCopy = product;
         connect(addButton, &QPushButton::clicked, [this, productCopy, row]() {
             if (productCopy.stock > 0) {
-                addToCart(productCopy.name, productCopy.retailPrice, productCopy.stock);
+                addToCart(productCopy);
                 QTableWidgetItem *stockItem = ui->twProducts->item(row, 2);
 
                 if (stockItem) {
@@ -127,15 +142,17 @@ void CashierWindow::loadProducts()
         });
     }
 }
-void CashierWindow::addToCart(const QString &productName, double price, int maxQuantity)
+void CashierWindow::addToCart(const Product &product)
 {
+    Money unitPrice = Money::fromDouble(product.retailPrice);
+
     for (int i = 0; i < ui->twCart->rowCount(); ++i) {
-        if (ui->twCart->item(i, 0)->text() == productName) {
+        if (ui->twCart->item(i, 0)->data(ProductIdRole).toInt() == product.id) {
             int currentQty = ui->twCart->item(i, 1)->text().toInt();
-            if (currentQty < maxQuantity) {
+            if (currentQty < product.stock) {
                 int newQty = currentQty + 1;
                 ui->twCart->item(i, 1)->setText(QString::number(newQty));
-                ui->twCart->item(i, 2)->setText(QString::number(newQty * price, 'f', 2));
+                ui->twCart->item(i, 2)->setText((unitPrice * newQty).toString());
                 updateTotal();
             }
             return;
@@ -144,24 +161,55 @@ void CashierWindow::addToCart(const QString &productName, double price, int maxQ
 
     int row = ui->twCart->rowCount();
     ui->twCart->insertRow(row);
-    ui->twCart->setItem(row, 0, new QTableWidgetItem(productName));
+
+    // Цена за единицу в копейках хранится при строке, итоги считаются от нее, а не от текста
+    QTableWidgetItem *nameItem = new QTableWidgetItem(product.name);
+    nameItem->setData(PriceRole, unitPrice.minor());
+    nameItem->setData(ProductIdRole, product.id);
+    nameItem->setData(CategoryIdRole, product.categoryId);
+    ui->twCart->setItem(row, 0, nameItem);
     ui->twCart->setItem(row, 1, new QTableWidgetItem("1"));
-    ui->twCart->setItem(row, 2, new QTableWidgetItem(QString::number(price, 'f', 2)));
+    ui->twCart->setItem(row, 2, new QTableWidgetItem(unitPrice.toString()));
     updateTotal();
 }
 
-void CashierWindow::updateTotal()
+QVector<BasketLine> CashierWindow::cartBasket() const
 {
-    double totalWithoutDiscount = 0.0;
+    QVector<BasketLine> basket;
+    basket.reserve(ui->twCart->rowCount());
+
     for (int i = 0; i < ui->twCart->rowCount(); ++i) {
-        totalWithoutDiscount += ui->twCart->item(i, 2)->text().toDouble();
+        QTableWidgetItem *nameItem = ui->twCart->item(i, 0);
+        basket.append({nameItem->data(ProductIdRole).toInt(),
+                       nameItem->data(CategoryIdRole).toInt(),
+                       Money::fromMinor(nameItem->data(PriceRole).toLongLong()),
+                       ui->twCart->item(i, 1)->text().toInt()});
     }
 
-    ui->lCostWithoutDiscount->setText(QString::number(totalWithoutDiscount, 'f', 2));
+    return basket;
+}
+
+PromotionResult CashierWindow::cartTotals(const QVector<BasketLine> &basket)
+{
+    if (!promotions.isCurrent()) {
+        Database db;
+        if (db.connectToDatabase()) {
+            promotions = PromotionEngine::load(db);
+        }
+    }
 
-    double discount = ui->dsbDiscount->value();
-    double totalWithDiscount = totalWithoutDiscount * (1 - discount / 100.0);
-    ui->lTotal->setText(QString::number(totalWithDiscount, 'f', 2));
+    PromotionResult totals = promotions.evaluate(basket);
+    totals.addManualDiscount(ui->dsbDiscount->value());
+    return totals;
+}
+
+void CashierWindow::updateTotal()
+{
+    PromotionResult totals = cartTotals(cartBasket());
+
+    ui->lCostWithoutDiscount->setText(totals.subtotal.toString());
+    ui->lTotal->setText(totals.total.toString());
+    ui->lTotal->setToolTip(totals.applied.join("\n"));
 }
 
 void CashierWindow::on_pbCashierAccount_clicked()
@@ -221,64 +269,66 @@ void CashierWindow::on_pbSave_clicked()
         return;
     }
 
-    double totalWithoutDiscount = ui->lCostWithoutDiscount->text().toDouble();
-    double discount = ui->dsbDiscount->value();
-
     Database db;
     if (!db.connectToDatabase()) {
         QMessageBox::critical(this, "Ошибка", "Не удалось подключиться к базе данных");
         return;
     }
 
+    QVector<BasketLine> basket = cartBasket();
     QList<SaleItem> saleItems;
-    for (int i = 0; i < ui->twCart->rowCount(); ++i) {
-        QString productName = ui->twCart->item(i, 0)->text();
-        int quantity = ui->twCart->item(i, 1)->text().toInt();
-        double price = ui->twCart->item(i, 2)->text().toDouble() / quantity;
-
-        auto allProducts = db.getAllProducts();
-        Product product;
-        for (const auto &p : allProducts) {
-            if (p.name == productName) {
-                product = p;
-                break;
-            }
-        }
 
-        if (product.id > 0) {
-            if (!db.checkProductAvailability(product.id, quantity)) {
-                QMessageBox::warning(this, "Ошибка",
-                                     QString("Недостаточно товара '%1' на складе. Доступно: %2")
-                                         .arg(productName)
-                                         .arg(product.stock));
-                return;
-            }
+    for (int i = 0; i < basket.size(); ++i) {
+        const BasketLine &line = basket[i];
+        QString productName = ui->twCart->item(i, 0)->text();
 
-            SaleItem item;
-            item.productId = product.id;
-            item.productName = productName;
-            item.quantity = quantity;
-            item.retailPrice = price;
-            item.totalPrice = price * quantity;
-            saleItems.append(item);
+        if (!db.checkProductAvailability(line.productId, line.quantity)) {
+            QMessageBox::warning(this, "Ошибка",
+                                 QString("Недостаточно товара '%1' на складе. Доступно: %2")
+                                     .arg(productName)
+                                     .arg(db.getProductById(line.productId).stock));
+            return;
         }
+
+        SaleItem item;
+        item.productId = line.productId;
+        item.productName = productName;
+        item.quantity = line.quantity;
+        item.retailPrice = line.unitPrice.toDouble();
+        item.totalPrice = (line.unitPrice * line.quantity).toDouble();
+        saleItems.append(item);
     }
 
+    PromotionResult totals = cartTotals(basket);
+
     Sale sale;
     sale.saleDate = QDateTime::currentDateTime();
     sale.cashierId = cashierId;
-    sale.totalAmount = totalWithoutDiscount;
-    sale.discountAmount = discount;
+    sale.customerId = -1;
+    sale.totalAmount = totals.subtotal.toDouble();
+    sale.discountAmount = totals.percent();
+    sale.finalAmount = totals.total.toDouble();
 
     int saleId = db.createSale(sale, saleItems);
     if (saleId != -1) {
-        SalesReceiptForm form(saleId, this);
+        Receipt receipt;
+        receipt.sale = sale;
+        receipt.items = saleItems;
+        for (SaleItem &item : receipt.items) {
+            item.saleId = saleId;
+        }
+        ReceiptCache::instance().insert(receipt);
+
+        SalesReceiptForm form(receipt, this);
         form.exec();
 
         ui->twCart->setRowCount(0);
         ui->dsbDiscount->setValue(0.0);
         loadProducts();
         loadSales();
+    } else if (Database::isBusyError(db.lastError())) {
+        QMessageBox::warning(this, "База занята",
+                             "База данных занята другой кассой. Продажа не сохранена, повторите попытку.");
     } else {
         QMessageBox::critical(this, "Ошибка", "Не удалось сохранить продажу!");
     }
@@ -5,6 +5,7 @@
 #include <QStandardItemModel>
 #include "database.h"
 #include "cartobserver.h"
+#include "promotionengine.h"
 
 namespace Ui {
 class CashierWindow;
@@ -36,7 +37,10 @@ private:
     int cashierId;
     QString cashierName;
     QStandardItemModel *salesModel;
-    void addToCart(const QString &productName, double price, int maxQuantity);
+    PromotionEngine promotions;
+    void addToCart(const Product &product);
+    QVector<BasketLine> cartBasket() const;
+    PromotionResult cartTotals(const QVector<BasketLine> &basket);
     void removeFromCart(int row);
     CartSubject *cartSubject;
     LoggerObserver *loggerObserver;
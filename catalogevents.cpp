@@ -0,0 +1,17 @@
+#include "catalogevents.h"
+
+CatalogEvents &CatalogEvents::instance()
+{
+    static CatalogEvents catalogEvents;
+    return catalogEvents;
+}
+
+CatalogEvents::CatalogEvents()
+    : QObject(nullptr)
+{
+}
+
+void CatalogEvents::notifyProductsChanged()
+{
+    emit productsChanged();
+}
@@ -0,0 +1,27 @@
+#ifndef CATALOGEVENTS_H
+#define CATALOGEVENTS_H
+
+#include <QObject>
+
+// Уведомления об изменении каталога товаров внутри процесса.
+//
+// Database сообщает о каждой успешной записи в products, в том числе из
+// рабочих потоков; окна, которые держат копию каталога, перечитывают ее
+// по сигналу, а не при каждом обращении к товару.
+class CatalogEvents : public QObject
+{
+    Q_OBJECT
+
+public:
+    static CatalogEvents &instance();
+
+    void notifyProductsChanged();
+
+signals:
+    void productsChanged();
+
+private:
+    CatalogEvents();
+};
+
+#endif // CATALOGEVENTS_H
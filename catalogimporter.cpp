@@ -0,0 +1,425 @@
+#include "catalogimporter.h"
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVector>
+
+// Пакет пишется одной транзакцией: крупнее - меньше фиксаций на диск,
+// мельче - короче блокировка записи, которую ждут кассы
+static const int BATCH_SIZE = 20000;
+static const int MAX_REPORTED_ERRORS = 1000;
+
+enum ImportField {
+    FieldType,
+    FieldArticle,
+    FieldName,
+    FieldCategory,
+    FieldPurchasePrice,
+    FieldRetailPrice,
+    FieldStock,
+    FieldSupplyNumber,
+    FieldSupplier,
+    FieldProductId,
+    FieldQuantity,
+    FieldSupplyDate,
+    FieldCount
+};
+
+// Понимает имена колонок базы и заголовки таблиц, выгруженных из программы
+static int fieldByName(const QString &name)
+{
+    static const QHash<QString, int> aliases = {
+        {"type", FieldType}, {"тип", FieldType},
+        {"article", FieldArticle}, {"артикул", FieldArticle},
+        {"name", FieldName}, {"название", FieldName}, {"товар", FieldName},
+        {"category", FieldCategory}, {"категория", FieldCategory},
+        {"purchase_price", FieldPurchasePrice}, {"закупочная цена", FieldPurchasePrice},
+        {"цена закупки", FieldPurchasePrice},
+        {"retail_price", FieldRetailPrice}, {"розничная цена", FieldRetailPrice},
+        {"stock", FieldStock}, {"остаток", FieldStock},
+        {"supply_number", FieldSupplyNumber}, {"номер поставки", FieldSupplyNumber},
+        {"supplier_name", FieldSupplier}, {"supplier", FieldSupplier}, {"поставщик", FieldSupplier},
+        {"product_id", FieldProductId}, {"id товара", FieldProductId},
+        {"quantity", FieldQuantity}, {"количество", FieldQuantity},
+        {"supply_date", FieldSupplyDate}, {"дата поставки", FieldSupplyDate}
+    };
+
+    return aliases.value(name.trimmed().toLower(), -1);
+}
+
+static QStringList splitCsvRecord(const QString &record, QChar delimiter)
+{
+    QStringList fields;
+    QString field;
+    bool quoted = false;
+
+    for (int i = 0; i < record.size(); i++) {
+        QChar c = record.at(i);
+
+        if (quoted) {
+            if (c == '"') {
+                if (i + 1 < record.size() && record.at(i + 1) == '"') {
+                    field += c;
+                    i++;
+                } else {
+                    quoted = false;
+                }
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == delimiter) {
+            fields.append(field);
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+
+    fields.append(field);
+    return fields;
+}
+
+static QChar detectDelimiter(const QString &header)
+{
+    QChar delimiter = ';';
+    for (QChar candidate : {QChar(','), QChar('\t')}) {
+        if (header.count(candidate) > header.count(delimiter)) {
+            delimiter = candidate;
+        }
+    }
+    return delimiter;
+}
+
+static bool parseNumber(QString text, double &value)
+{
+    bool ok = false;
+    value = text.replace(',', '.').toDouble(&ok);
+    return ok && value >= 0;
+}
+
+static bool parseInt(const QString &text, int &value)
+{
+    bool ok = false;
+    value = text.toInt(&ok);
+    return ok;
+}
+
+static QDateTime parseDate(const QString &text)
+{
+    QDateTime date = QDateTime::fromString(text, Qt::ISODate);
+    if (!date.isValid()) {
+        date = QDateTime::fromString(text, "dd.MM.yyyy HH:mm");
+    }
+    if (!date.isValid()) {
+        date = QDateTime(QDate::fromString(text, "dd.MM.yyyy"), QTime(0, 0));
+    }
+    return date;
+}
+
+static bool buildRecord(const QVector<QString> &values, qint64 line, const QString &runStamp,
+                        ImportRecord &record, QString &error)
+{
+    QString type = values[FieldType].toLower();
+
+    if (type == "supply" || type == "поставка") {
+        record.kind = ImportRecord::SupplyRecord;
+    } else if (type == "product" || type == "товар") {
+        record.kind = ImportRecord::ProductRecord;
+    } else if (!type.isEmpty()) {
+        error = QString("Неизвестный тип записи: %1").arg(values[FieldType]);
+        return false;
+    } else {
+        record.kind = values[FieldSupplier].isEmpty() && values[FieldQuantity].isEmpty()
+                          ? ImportRecord::ProductRecord
+                          : ImportRecord::SupplyRecord;
+    }
+
+    record.line = line;
+    record.article = values[FieldArticle];
+    record.productId = 0;
+    record.stock = -1;
+    record.quantity = 0;
+    record.purchasePrice = 0;
+    record.retailPrice = 0;
+
+    if (record.kind == ImportRecord::ProductRecord) {
+        record.name = values[FieldName];
+        record.categoryName = values[FieldCategory];
+
+        if (record.article.isEmpty()) {
+            error = "Не указан артикул";
+            return false;
+        }
+        if (record.name.isEmpty()) {
+            error = "Не указано название";
+            return false;
+        }
+        if (!parseNumber(values[FieldPurchasePrice], record.purchasePrice)) {
+            error = QString("Некорректная закупочная цена: %1").arg(values[FieldPurchasePrice]);
+            return false;
+        }
+        if (!parseNumber(values[FieldRetailPrice], record.retailPrice)) {
+            error = QString("Некорректная розничная цена: %1").arg(values[FieldRetailPrice]);
+            return false;
+        }
+        if (!values[FieldStock].isEmpty() && (!parseInt(values[FieldStock], record.stock) || record.stock < 0)) {
+            error = QString("Некорректный остаток: %1").arg(values[FieldStock]);
+            return false;
+        }
+        return true;
+    }
+
+    record.supplierName = values[FieldSupplier];
+    record.supplyNumber = values[FieldSupplyNumber];
+
+    if (!values[FieldProductId].isEmpty()
+        && (!parseInt(values[FieldProductId], record.productId) || record.productId <= 0)) {
+        error = QString("Некорректный ID товара: %1").arg(values[FieldProductId]);
+        return false;
+    }
+    if (record.productId <= 0 && record.article.isEmpty()) {
+        error = "Не указан артикул товара";
+        return false;
+    }
+    if (record.supplierName.isEmpty()) {
+        error = "Не указан поставщик";
+        return false;
+    }
+    if (!parseInt(values[FieldQuantity], record.quantity) || record.quantity <= 0) {
+        error = QString("Некорректное количество: %1").arg(values[FieldQuantity]);
+        return false;
+    }
+    if (!parseNumber(values[FieldPurchasePrice], record.purchasePrice)) {
+        error = QString("Некорректная цена закупки: %1").arg(values[FieldPurchasePrice]);
+        return false;
+    }
+
+    if (values[FieldSupplyDate].isEmpty()) {
+        record.supplyDate = QDateTime::currentDateTime();
+    } else {
+        record.supplyDate = parseDate(values[FieldSupplyDate]);
+        if (!record.supplyDate.isValid()) {
+            error = QString("Некорректная дата поставки: %1").arg(values[FieldSupplyDate]);
+            return false;
+        }
+    }
+
+    // Номер строки делает номер уникальным в пределах одного импорта
+    if (record.supplyNumber.isEmpty()) {
+        record.supplyNumber = QString("IMP%1-%2").arg(runStamp).arg(line);
+    }
+
+    return true;
+}
+
+CatalogImporter::CatalogImporter(const QString &filePath, int userId, QObject *parent)
+    : QThread(parent)
+    , filePath(filePath)
+    , userId(userId)
+{
+}
+
+void CatalogImporter::run()
+{
+    importReport = ImportReport();
+    importReport.ok = false;
+    importReport.rowsRead = 0;
+    importReport.productsInserted = 0;
+    importReport.productsUpdated = 0;
+    importReport.suppliesInserted = 0;
+    importReport.errorCount = 0;
+    importReport.elapsedMs = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        importReport.errorString = "Не удалось открыть файл: " + file.errorString();
+        return;
+    }
+
+    Database db;
+    if (!db.connectToDatabase()) {
+        importReport.errorString = "Не удалось подключиться к базе данных";
+        return;
+    }
+
+    QString suffix = QFileInfo(filePath).suffix().toLower();
+    bool jsonLines = suffix == "jsonl" || suffix == "ndjson" || suffix == "json";
+    QString runStamp = QDateTime::currentDateTime().toString("yyyyMMddHHmmss");
+
+    QList<ImportRecord> batch;
+    batch.reserve(BATCH_SIZE);
+
+    QVector<int> columns;
+    QChar delimiter;
+    QVector<QString> values(FieldCount);
+    QString pending;
+    qint64 line = 0;
+    qint64 recordLine = 0;
+    int lastPercent = -1;
+
+    importReport.ok = true;
+
+    // Файл читается построчно через буфер QFile и никогда не загружается целиком
+    while (!file.atEnd()) {
+        QByteArray raw = file.readLine();
+        line++;
+
+        if (line == 1 && raw.startsWith("\xEF\xBB\xBF")) {
+            raw.remove(0, 3);
+        }
+
+        QString text;
+        if (jsonLines) {
+            if (raw.trimmed().isEmpty()) {
+                continue;
+            }
+            recordLine = line;
+        } else {
+            text = QString::fromUtf8(raw);
+            while (text.endsWith('\n') || text.endsWith('\r')) {
+                text.chop(1);
+            }
+
+            // Поле в кавычках может содержать перевод строки:
+            // запись продолжается, пока число кавычек нечетное
+            if (pending.isEmpty()) {
+                recordLine = line;
+                pending = text;
+            } else {
+                pending += '\n' + text;
+            }
+            if (pending.count('"') % 2 != 0 && !file.atEnd()) {
+                continue;
+            }
+            text = pending;
+            pending.clear();
+
+            if (text.trimmed().isEmpty()) {
+                continue;
+            }
+
+            if (columns.isEmpty()) {
+                delimiter = detectDelimiter(text);
+                bool hasKnownColumn = false;
+                for (const QString &name : splitCsvRecord(text, delimiter)) {
+                    int field = fieldByName(name);
+                    columns.append(field);
+                    hasKnownColumn = hasKnownColumn || field >= 0;
+                }
+                if (!hasKnownColumn) {
+                    importReport.ok = false;
+                    importReport.errorString = "В первой строке файла нет известных колонок";
+                    break;
+                }
+                continue;
+            }
+        }
+
+        importReport.rowsRead++;
+        values.fill(QString());
+
+        if (jsonLines) {
+            QJsonParseError parseError;
+            QJsonDocument document = QJsonDocument::fromJson(raw, &parseError);
+            if (!document.isObject()) {
+                addError(recordLine, parseError.error != QJsonParseError::NoError
+                                         ? "Ошибка JSON: " + parseError.errorString()
+                                         : QString("Ожидался объект JSON"));
+                continue;
+            }
+
+            QJsonObject object = document.object();
+            for (auto it = object.constBegin(); it != object.constEnd(); ++it) {
+                int field = fieldByName(it.key());
+                if (field < 0) {
+                    continue;
+                }
+                values[field] = it.value().isDouble() ? QString::number(it.value().toDouble(), 'g', 15)
+                                                      : it.value().toString().trimmed();
+            }
+        } else {
+            QStringList fields = splitCsvRecord(text, delimiter);
+            for (int i = 0; i < fields.size() && i < columns.size(); i++) {
+                if (columns[i] >= 0) {
+                    values[columns[i]] = fields[i].trimmed();
+                }
+            }
+        }
+
+        ImportRecord record;
+        QString error;
+        if (!buildRecord(values, recordLine, runStamp, record, error)) {
+            addError(recordLine, error);
+            continue;
+        }
+        batch.append(record);
+
+        if (batch.size() >= BATCH_SIZE) {
+            if (!flushBatch(db, batch)) {
+                break;
+            }
+
+            int percent = file.size() > 0 ? static_cast<int>(file.pos() * 100 / file.size()) : 100;
+            if (percent != lastPercent) {
+                lastPercent = percent;
+                emit progress(percent);
+            }
+
+            if (isInterruptionRequested()) {
+                importReport.ok = false;
+                importReport.errorString = "Импорт прерван, загруженные строки сохранены";
+                break;
+            }
+        }
+    }
+
+    if (importReport.ok && !batch.isEmpty()) {
+        flushBatch(db, batch);
+    }
+
+    // После большой загрузки остаток считается от снимка, а не по всему журналу
+    if (importReport.productsInserted + importReport.productsUpdated + importReport.suppliesInserted > 0) {
+        db.createStockSnapshots();
+    }
+
+    emit progress(100);
+    importReport.elapsedMs = timer.elapsed();
+}
+
+bool CatalogImporter::flushBatch(Database &db, QList<ImportRecord> &batch)
+{
+    ImportBatchResult result;
+    QList<ImportRowError> errors;
+
+    if (!db.importBatch(batch, userId, result, errors)) {
+        importReport.ok = false;
+        importReport.errorString = "Ошибка записи в базу данных: " + db.lastError().text();
+        return false;
+    }
+
+    importReport.productsInserted += result.productsInserted;
+    importReport.productsUpdated += result.productsUpdated;
+    importReport.suppliesInserted += result.suppliesInserted;
+
+    for (const ImportRowError &error : errors) {
+        addError(error.line, error.message);
+    }
+
+    batch.clear();
+    return true;
+}
+
+void CatalogImporter::addError(qint64 line, const QString &message)
+{
+    importReport.errorCount++;
+    if (importReport.errors.size() < MAX_REPORTED_ERRORS) {
+        importReport.errors.append({line, message});
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef CATALOGIMPORTER_H
+#define CATALOGIMPORTER_H
+
+#include <QThread>
+#include <QString>
+#include "database.h"
+
+struct ImportReport {
+    bool ok;
+    QString errorString;
+    qint64 rowsRead;
+    int productsInserted;
+    int productsUpdated;
+    int suppliesInserted;
+    qint64 errorCount;
+    QList<ImportRowError> errors;
+    qint64 elapsedMs;
+};
+
+// Импорт каталога из CSV или JSONL в фоновом потоке.
+// Файл читается потоком и пишется пакетами, каждый пакет - одна транзакция.
+// Товары ищутся по артикулу: найденные обновляются, новые добавляются.
+// Строки с ошибками пропускаются и попадают в отчет с номером строки.
+class CatalogImporter : public QThread
+{
+    Q_OBJECT
+
+public:
+    CatalogImporter(const QString &filePath, int userId, QObject *parent = nullptr);
+
+    ImportReport report() const { return importReport; }
+
+signals:
+    void progress(int percent);
+
+protected:
+    void run() override;
+
+private:
+    QString filePath;
+    int userId;
+    ImportReport importReport;
+
+    void addError(qint64 line, const QString &message);
+    bool flushBatch(Database &db, QList<ImportRecord> &batch);
+};
+
+#endif // CATALOGIMPORTER_H
@@ -0,0 +1,88 @@
+#include "categorycache.h"
+#include <QMutexLocker>
+
+static const int RELOAD_INTERVAL_SECS = 300;
+
+// Не чаще этого перечитывать справочник из-за неизвестного id
+static const int MISS_RELOAD_SECS = 5;
+
+CategoryCache &CategoryCache::instance()
+{
+    static CategoryCache categoryCache;
+    return categoryCache;
+}
+
+CategoryCache::CategoryCache()
+    : stale(true)
+{
+}
+
+QList<ProductCategory> CategoryCache::categories(Database &db)
+{
+    QMutexLocker locker(&mutex);
+    ensureCurrent(db, QDateTime::currentDateTime());
+    return list;
+}
+
+QString CategoryCache::name(Database &db, int categoryId)
+{
+    if (categoryId <= 0) {
+        return QString();
+    }
+
+    QMutexLocker locker(&mutex);
+    QDateTime now = QDateTime::currentDateTime();
+    ensureCurrent(db, now);
+    ensureKnown(db, categoryId, now);
+    return names.value(categoryId);
+}
+
+void CategoryCache::resolve(Database &db, QList<Product> &products)
+{
+    QMutexLocker locker(&mutex);
+    QDateTime now = QDateTime::currentDateTime();
+    ensureCurrent(db, now);
+
+    for (Product &product : products) {
+        if (product.categoryId > 0) {
+            ensureKnown(db, product.categoryId, now);
+            product.categoryName = names.value(product.categoryId);
+        } else {
+            product.categoryName.clear();
+        }
+    }
+}
+
+void CategoryCache::invalidate()
+{
+    QMutexLocker locker(&mutex);
+    stale = true;
+}
+
+void CategoryCache::ensureCurrent(Database &db, const QDateTime &now)
+{
+    if (stale || !loadedAt.isValid() || loadedAt.secsTo(now) >= RELOAD_INTERVAL_SECS || now < loadedAt) {
+        reload(db, now);
+    }
+}
+
+void CategoryCache::ensureKnown(Database &db, int categoryId, const QDateTime &now)
+{
+    if (!names.contains(categoryId) && loadedAt.secsTo(now) >= MISS_RELOAD_SECS) {
+        reload(db, now);
+    }
+}
+
+void CategoryCache::reload(Database &db, const QDateTime &now)
+{
+    list = db.getAllCategories();
+
+    names.clear();
+    names.reserve(list.size());
+    for (const ProductCategory &category : list) {
+        names.insert(category.id, category.name);
+    }
+
+    loadedAt = now;
+    stale = false;
+}
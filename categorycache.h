@@ -0,0 +1,41 @@
+#ifndef CATEGORYCACHE_H
+#define CATEGORYCACHE_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include "database.h"
+
+// Справочник категорий товаров на весь процесс.
+//
+// Категорий немного, и меняются они редко, поэтому список читается один раз.
+// Запросы товаров возвращают только category_id, название подставляется
+// отсюда при выводе. addCategory и импорт каталога сбрасывают справочник.
+// Категории, добавленные другим процессом, подхватываются раз в
+// RELOAD_INTERVAL_SECS или при первом неизвестном id.
+class CategoryCache
+{
+public:
+    static CategoryCache &instance();
+
+    QList<ProductCategory> categories(Database &db);
+    QString name(Database &db, int categoryId);
+    void resolve(Database &db, QList<Product> &products);
+
+    void invalidate();
+
+private:
+    CategoryCache();
+
+    void ensureCurrent(Database &db, const QDateTime &now);
+    void ensureKnown(Database &db, int categoryId, const QDateTime &now);
+    void reload(Database &db, const QDateTime &now);
+
+    QList<ProductCategory> list;
+    QHash<int, QString> names;
+    QDateTime loadedAt;
+    bool stale;
+    QMutex mutex;
+};
+
+#endif // CATEGORYCACHE_H
@@ -1,6 +1,7 @@
 #include "clientcartform.h"
 #include "ui_clientcartform.h"
 #include "salesreceiptform.h"
+#include "promotionengine.h"
 #include <QMessageBox>
 #include <QHeaderView>
 #include <QDebug>
@@ -48,6 +49,10 @@ void ClientCartForm::loadCartItems()
     ui->twCart->setRowCount(0);
     cartItems.clear();
 
+    if (!promotions.isCurrent()) {
+        promotions = PromotionEngine::load(db);
+    }
+
     cartItems = db.getCartItems(userId);
 
     for (int i = 0; i < cartItems.size(); i++) {
@@ -63,8 +68,8 @@ void ClientCartForm::loadCartItems()
         quantityItem->setTextAlignment(Qt::AlignCenter);
         ui->twCart->setItem(i, 1, quantityItem);
 
-        double total = item.retailPrice * item.quantity;
-        QTableWidgetItem *totalItem = new QTableWidgetItem(QString::number(total, 'f', 2) + " ₽");
+        Money total = Money::fromDouble(item.retailPrice) * item.quantity;
+        QTableWidgetItem *totalItem = new QTableWidgetItem(total.toString() + " ₽");
         totalItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
         ui->twCart->setItem(i, 2, totalItem);
     }
@@ -74,39 +79,19 @@ void ClientCartForm::loadCartItems()
 
 void ClientCartForm::updateTotals()
 {
-    double costWithoutDiscount = 0;
+    QVector<BasketLine> basket;
+    basket.reserve(cartItems.size());
 
     for (const CartItem &item : cartItems) {
-        costWithoutDiscount += item.retailPrice * item.quantity;
+        basket.append({item.productId, item.categoryId, Money::fromDouble(item.retailPrice), item.quantity});
     }
 
-    calculateDiscount();
+    PromotionResult totals = promotions.evaluate(basket);
 
-    ui->lCostWithoutDiscount->setText(QString::number(costWithoutDiscount, 'f', 2) + " ₽");
-}
-
-void ClientCartForm::calculateDiscount()
-{
-    double costWithoutDiscount = 0;
-    double totalQuantity = 0;
-
-    for (const CartItem &item : cartItems) {
-        costWithoutDiscount += item.retailPrice * item.quantity;
-        totalQuantity += item.quantity;
-    }
-
-    double discountPercent = 0;
-    if (totalQuantity >= 3 && totalQuantity <= 5) {
-        discountPercent = 5;
-    } else if (totalQuantity > 5) {
-        discountPercent = 10;
-    }
-
-    double discountAmount = costWithoutDiscount * (discountPercent / 100);
-    double totalAmount = costWithoutDiscount - discountAmount;
-
-    ui->lDiscount->setText(QString::number(discountPercent, 'f', 1) + "%");
-    ui->lTotal->setText(QString::number(totalAmount, 'f', 2) + " ₽");
+    ui->lCostWithoutDiscount->setText(totals.subtotal.toString() + " ₽");
+    ui->lDiscount->setText(QString::number(totals.percent(), 'f', 1) + "%");
+    ui->lDiscount->setToolTip(totals.applied.join("\n"));
+    ui->lTotal->setText(totals.total.toString() + " ₽");
 }
 
 void ClientCartForm::on_pbBuy_clicked()
@@ -155,6 +140,10 @@ void ClientCartForm::on_pbBuy_clicked()
 
         emit cartUpdated();
         accept();
+    } else if (Database::isBusyError(db.lastError())) {
+        QMessageBox::warning(this, "База занята",
+                             "База данных занята. Покупка не оформлена, повторите попытку.");
+        ui->pbBuy->setEnabled(true);
     }
 
     inProgress = false;
@@ -4,6 +4,7 @@
 #include <QDialog>
 #include <QTableWidgetItem>
 #include "database.h"
+#include "promotionengine.h"
 
 namespace Ui {
 class ClientCartForm;
@@ -30,10 +31,10 @@ private:
     Ui::ClientCartForm *ui;
     int userId;
     QList<CartItem> cartItems;
+    PromotionEngine promotions;
 
     void setupTable();
     void updateTotals();
-    void calculateDiscount();
 };
 
 #endif // CLIENTCARTFORM_H
@@ -0,0 +1,220 @@
+#include "csvexporter.h"
+#include "categorycache.h"
+#include <QAtomicInt>
+#include <QSaveFile>
+
+static const int PAGE_SIZE = 5000;
+static const int CHUNK_SIZE = 256 * 1024;
+
+static QAtomicInt exporterCounter;
+
+enum ColumnFormat {
+    TextColumn,
+    MoneyColumn,
+    PercentColumn,
+    DateTimeColumn,
+    CategoryColumn
+};
+
+struct ExportColumn {
+    const char *header;
+    ColumnFormat format;
+};
+
+// Колонки совпадают с видимыми колонками таблиц окна администратора
+// и с порядком полей в Database::exportQueryText()
+static QList<ExportColumn> exportColumns(Database::ExportTable table)
+{
+    switch (table) {
+    case Database::ExportProducts:
+        return {{"ID", TextColumn}, {"Артикул", TextColumn}, {"Название", TextColumn},
+                {"Категория", CategoryColumn}, {"Закупочная цена", MoneyColumn},
+                {"Розничная цена", MoneyColumn}, {"Остаток", TextColumn},
+                {"Создан", DateTimeColumn}, {"Обновлен", DateTimeColumn}};
+    case Database::ExportSupplies:
+        return {{"ID", TextColumn}, {"Номер поставки", TextColumn}, {"Поставщик", TextColumn},
+                {"Товар", TextColumn}, {"Количество", TextColumn}, {"Цена закупки", MoneyColumn},
+                {"Сумма", MoneyColumn}, {"Дата поставки", DateTimeColumn},
+                {"Кем создана", TextColumn}, {"Создано", DateTimeColumn}};
+    case Database::ExportSales:
+        return {{"ID", TextColumn}, {"Номер чека", TextColumn}, {"Дата продажи", DateTimeColumn},
+                {"Кассир", TextColumn}, {"Клиент", TextColumn}, {"Сумма", MoneyColumn},
+                {"Скидка, %", PercentColumn}, {"Итоговая сумма", MoneyColumn},
+                {"Создано", DateTimeColumn}};
+    }
+
+    return {};
+}
+
+static void appendField(QByteArray &buffer, const QString &value, bool first)
+{
+    if (!first) {
+        buffer += ';';
+    }
+
+    buffer += '"';
+    if (value.contains('"')) {
+        buffer += QString(value).replace("\"", "\"\"").toUtf8();
+    } else {
+        buffer += value.toUtf8();
+    }
+    buffer += '"';
+}
+
+CsvExporter::CsvExporter(const QString &dbPath, Database::ExportTable table, const QString &targetPath,
+                         QObject *parent)
+    : QThread(parent)
+    , dbPath(dbPath)
+    , table(table)
+    , targetPath(targetPath)
+    , success(false)
+    , writtenRows(0)
+{
+}
+
+void CsvExporter::run()
+{
+    success = false;
+    writtenRows = 0;
+
+    // QSaveFile пишет во временный файл и подменяет целевой только при commit()
+    QSaveFile file(targetPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = "Не удалось открыть файл: " + file.errorString();
+        return;
+    }
+
+    QList<ExportColumn> columns = exportColumns(table);
+
+    // Запрос товаров отдает category_id, название берется из общего справочника
+    Database categoryDb;
+    if (table == Database::ExportProducts && !categoryDb.connectToDatabase(dbPath)) {
+        error = "Не удалось подключиться к базе данных";
+        file.cancelWriting();
+        return;
+    }
+
+    QString connectionName = QString("csv_export_%1").arg(exporterCounter.fetchAndAddRelaxed(1));
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(dbPath);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+
+        if (!db.open()) {
+            error = "Не удалось подключиться к базе данных: " + db.lastError().text();
+        } else {
+            qint64 totalRows = 0;
+            QSqlQuery countQuery(db);
+            if (countQuery.exec(Database::exportCountQueryText(table)) && countQuery.next()) {
+                totalRows = countQuery.value(0).toLongLong();
+            }
+            countQuery.finish();
+
+            QByteArray buffer;
+            buffer.reserve(CHUNK_SIZE + 4096);
+
+            for (int i = 0; i < columns.size(); i++) {
+                appendField(buffer, QString::fromUtf8(columns[i].header), i == 0);
+            }
+            buffer += '\n';
+
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            query.prepare(Database::exportQueryText(table));
+
+            qint64 afterId = 0;
+            int lastPercent = -1;
+            bool failed = false;
+
+            for (;;) {
+                if (isInterruptionRequested()) {
+                    error = "Экспорт отменен";
+                    failed = true;
+                    break;
+                }
+
+                query.bindValue(":after_id", afterId);
+                query.bindValue(":limit", PAGE_SIZE);
+
+                if (!query.exec()) {
+                    error = "Ошибка чтения из базы данных: " + query.lastError().text();
+                    failed = true;
+                    break;
+                }
+
+                int fetched = 0;
+                while (query.next()) {
+                    fetched++;
+                    afterId = query.value(0).toLongLong();
+
+                    for (int i = 0; i < columns.size(); i++) {
+                        QVariant value = query.value(i);
+                        QString text;
+
+                        if (columns[i].format == MoneyColumn) {
+                            text = QString::number(value.toDouble(), 'f', 2);
+                        } else if (columns[i].format == PercentColumn) {
+                            // discount_amount хранит процент скидки, а не рубли
+                            text = QString::number(value.toDouble(), 'f', 1);
+                        } else if (columns[i].format == CategoryColumn) {
+                            text = CategoryCache::instance().name(categoryDb, value.toInt());
+                        } else if (columns[i].format == DateTimeColumn) {
+                            text = value.toDateTime().toString("dd.MM.yyyy HH:mm");
+                        } else {
+                            text = value.toString();
+                        }
+
+                        appendField(buffer, text, i == 0);
+                    }
+                    buffer += '\n';
+                    writtenRows++;
+
+                    if (buffer.size() >= CHUNK_SIZE) {
+                        if (file.write(buffer) != buffer.size()) {
+                            error = "Ошибка записи файла: " + file.errorString();
+                            failed = true;
+                            break;
+                        }
+                        buffer.resize(0);
+                    }
+                }
+                query.finish();
+
+                if (failed) {
+                    break;
+                }
+
+                int percent = totalRows > 0 ? static_cast<int>(qMin<qint64>(writtenRows * 100 / totalRows, 100)) : 100;
+                if (percent != lastPercent) {
+                    lastPercent = percent;
+                    emit progress(percent);
+                }
+
+                if (fetched < PAGE_SIZE) {
+                    break;
+                }
+            }
+
+            if (!failed && !buffer.isEmpty() && file.write(buffer) != buffer.size()) {
+                error = "Ошибка записи файла: " + file.errorString();
+                failed = true;
+            }
+
+            success = !failed;
+            db.close();
+        }
+    }
+
+    QSqlDatabase::removeDatabase(connectionName);
+
+    if (!success) {
+        file.cancelWriting();
+        return;
+    }
+
+    if (!file.commit()) {
+        error = "Не удалось сохранить файл: " + file.errorString();
+        success = false;
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef CSVEXPORTER_H
+#define CSVEXPORTER_H
+
+#include <QThread>
+#include <QString>
+#include "database.h"
+
+// Выгрузка таблицы в CSV в фоновом потоке прямо из базы.
+// Строки читаются страницами однонаправленным курсором и копятся
+// в буфере фиксированного размера, поэтому память не растет с размером таблицы.
+// Файл появляется под своим именем только после успешного завершения.
+class CsvExporter : public QThread
+{
+    Q_OBJECT
+
+public:
+    CsvExporter(const QString &dbPath, Database::ExportTable table, const QString &targetPath,
+                QObject *parent = nullptr);
+
+    bool succeeded() const { return success; }
+    QString errorString() const { return error; }
+    qint64 rowsWritten() const { return writtenRows; }
+
+signals:
+    void progress(int percent);
+
+protected:
+    void run() override;
+
+private:
+    QString dbPath;
+    Database::ExportTable table;
+    QString targetPath;
+
+    bool success;
+    QString error;
+    qint64 writtenRows;
+};
+
+#endif // CSVEXPORTER_H
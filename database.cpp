@@ -1,8 +1,361 @@
 #include "database.h"
+#include "money.h"
+#include "promotionengine.h"
+#include "priceindex.h"
+#include "catalogevents.h"
+#include "categorycache.h"
 #include <QCryptographicHash>
+#include <QAtomicInt>
+#include <QThread>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <algorithm>
+
+static QAtomicInt connectionCounter;
+
+// Повторы записи при SQLITE_BUSY: драйвер сам ждет BUSY_TIMEOUT_MS,
+// затем транзакция перезапускается с экспоненциальной задержкой
+static const int BUSY_TIMEOUT_MS = 200;
+static const int MAX_TRANSACTION_ATTEMPTS = 8;
+static const int RETRY_BASE_DELAY_MS = 10;
+static const int RETRY_MAX_DELAY_MS = 1000;
+
+// SQLite по умолчанию подключает не больше 10 баз (SQLITE_LIMIT_ATTACHED),
+// поэтому архивы подключаются под запрос, а не все сразу
+static const int MAX_ATTACHED_ARCHIVES = 10;
+
+// Версия схемы в PRAGMA user_version, см. migrateSchema()
+static const int SCHEMA_VERSION = 10;
+
+// Версия 2: остаток ведется журналом движений stock_movements вместо
+// изменения products.stock триггерами. Старая колонка products.stock
+// остается в таблице, но больше не используется.
+static const char *const stockLedgerMigration[] = {
+    "CREATE TABLE IF NOT EXISTS stock_movements ("
+    "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+    "product_id INTEGER NOT NULL, "
+    "quantity INTEGER NOT NULL CHECK (quantity <> 0), "
+    "reason TEXT NOT NULL CHECK (reason IN ('initial', 'supply', 'sale', 'cart_reserve', "
+    "'cart_release', 'adjustment', 'reconcile')), "
+    "reference_id INTEGER, "
+    "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP, "
+    "FOREIGN KEY (product_id) REFERENCES products(id) ON DELETE CASCADE)",
+
+    "CREATE TABLE IF NOT EXISTS stock_snapshots ("
+    "product_id INTEGER PRIMARY KEY, "
+    "stock INTEGER NOT NULL, "
+    "movement_id INTEGER NOT NULL, "
+    "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP, "
+    "FOREIGN KEY (product_id) REFERENCES products(id) ON DELETE CASCADE)",
+
+    "CREATE INDEX IF NOT EXISTS idx_stock_movements_product ON stock_movements(product_id, id)",
+
+    "CREATE VIEW IF NOT EXISTS product_stock AS "
+    "SELECT p.id AS product_id, "
+    "COALESCE(s.stock, 0) + COALESCE(("
+    "SELECT SUM(m.quantity) FROM stock_movements m "
+    "WHERE m.product_id = p.id AND m.id > COALESCE(s.movement_id, 0)), 0) AS stock "
+    "FROM products p "
+    "LEFT JOIN stock_snapshots s ON s.product_id = p.id",
+
+    // Текущий остаток (уже за вычетом корзин) становится начальным движением
+    "INSERT INTO stock_movements (product_id, quantity, reason) "
+    "SELECT id, stock, 'initial' FROM products WHERE stock <> 0",
+
+    "DROP TRIGGER IF EXISTS update_stock_on_supply",
+    "DROP TRIGGER IF EXISTS update_stock_on_sale",
+    "DROP TRIGGER IF EXISTS decrease_stock_on_cart_insert",
+    "DROP TRIGGER IF EXISTS update_stock_on_cart_update",
+    "DROP TRIGGER IF EXISTS increase_stock_on_cart_delete",
+
+    "CREATE TRIGGER IF NOT EXISTS check_stock_on_movement "
+    "BEFORE INSERT ON stock_movements "
+    "FOR EACH ROW "
+    "WHEN NEW.quantity < 0 AND NEW.reason <> 'reconcile' "
+    "BEGIN "
+    "SELECT CASE "
+    "WHEN (SELECT stock FROM product_stock WHERE product_id = NEW.product_id) + NEW.quantity < 0 "
+    "THEN RAISE(ABORT, 'Недостаточно товара на складе') "
+    "END; "
+    "END",
+
+    "CREATE TRIGGER IF NOT EXISTS record_supply_movement "
+    "AFTER INSERT ON supplies "
+    "FOR EACH ROW "
+    "BEGIN "
+    "INSERT INTO stock_movements (product_id, quantity, reason, reference_id) "
+    "VALUES (NEW.product_id, NEW.quantity, 'supply', NEW.id); "
+    "END",
+
+    "CREATE TRIGGER IF NOT EXISTS record_sale_movement "
+    "AFTER INSERT ON sale_items "
+    "FOR EACH ROW "
+    "BEGIN "
+    "INSERT INTO stock_movements (product_id, quantity, reason, reference_id) "
+    "VALUES (NEW.product_id, -NEW.quantity, 'sale', NEW.sale_id); "
+    "END",
+
+    "CREATE TRIGGER IF NOT EXISTS record_cart_insert_movement "
+    "AFTER INSERT ON cart_items "
+    "FOR EACH ROW "
+    "BEGIN "
+    "INSERT INTO stock_movements (product_id, quantity, reason, reference_id) "
+    "VALUES (NEW.product_id, -NEW.quantity, 'cart_reserve', NEW.user_id); "
+    "END",
+
+    "CREATE TRIGGER IF NOT EXISTS record_cart_update_movement "
+    "AFTER UPDATE OF quantity ON cart_items "
+    "FOR EACH ROW "
+    "WHEN NEW.quantity <> OLD.quantity "
+    "BEGIN "
+    "INSERT INTO stock_movements (product_id, quantity, reason, reference_id) "
+    "VALUES (NEW.product_id, OLD.quantity - NEW.quantity, "
+    "CASE WHEN NEW.quantity > OLD.quantity THEN 'cart_reserve' ELSE 'cart_release' END, "
+    "NEW.user_id); "
+    "END",
+
+    "CREATE TRIGGER IF NOT EXISTS record_cart_delete_movement "
+    "AFTER DELETE ON cart_items "
+    "FOR EACH ROW "
+    "BEGIN "
+    "INSERT INTO stock_movements (product_id, quantity, reason, reference_id) "
+    "VALUES (OLD.product_id, OLD.quantity, 'cart_release', OLD.user_id); "
+    "END"
+};
+
+// Версия 3: покрывающие индексы для сверки остатков, суммы по товару
+// считаются только по индексам
+static const char *const reconciliationIndexMigration[] = {
+    "DROP INDEX IF EXISTS idx_supplies_product",
+    "CREATE INDEX IF NOT EXISTS idx_supplies_product ON supplies(product_id, quantity)",
+    "DROP INDEX IF EXISTS idx_sale_items_product",
+    "CREATE INDEX IF NOT EXISTS idx_sale_items_product ON sale_items(product_id, quantity)",
+    "CREATE INDEX IF NOT EXISTS idx_stock_movements_manual ON stock_movements(product_id, quantity) "
+    "WHERE reason IN ('initial', 'adjustment', 'reconcile')"
+};
+
+// Версия 4: проданное количество по товарам, перенесенное в архивы продаж,
+// чтобы сверка остатков не открывала архивные файлы
+static const char *const archiveMigration[] = {
+    "CREATE TABLE IF NOT EXISTS archived_sale_totals ("
+    "product_id INTEGER PRIMARY KEY, "
+    "quantity INTEGER NOT NULL DEFAULT 0)"
+};
+
+// Версия 5: сумма поставки считается триггером, только если ее не передали,
+// пакетный импорт заполняет total_amount сам и не делает UPDATE на каждую строку
+static const char *const supplyTotalMigration[] = {
+    "DROP TRIGGER IF EXISTS calculate_supply_total_amount",
+
+    "CREATE TRIGGER IF NOT EXISTS calculate_supply_total_amount "
+    "AFTER INSERT ON supplies "
+    "WHEN NEW.total_amount IS NULL "
+    "BEGIN "
+    "UPDATE supplies "
+    "SET total_amount = NEW.quantity * NEW.purchase_price "
+    "WHERE id = NEW.id; "
+    "END"
+};
+
+// Версия 6: денежные значения хранятся округленными до копеек, триггеры
+// округляют то, что вычисляют сами. Колонки остаются REAL: их читают архивы,
+// снимок и выгрузки, а значение с двумя знаками точно переводится в Money.
+static const char *const moneyRoundingMigration[] = {
+    "UPDATE products SET purchase_price = ROUND(purchase_price, 2), retail_price = ROUND(retail_price, 2) "
+    "WHERE purchase_price <> ROUND(purchase_price, 2) OR retail_price <> ROUND(retail_price, 2)",
+
+    "UPDATE supplies SET purchase_price = ROUND(purchase_price, 2), total_amount = ROUND(total_amount, 2) "
+    "WHERE purchase_price <> ROUND(purchase_price, 2) OR total_amount <> ROUND(total_amount, 2)",
+
+    "UPDATE sale_items SET retail_price = ROUND(retail_price, 2), total_price = ROUND(total_price, 2) "
+    "WHERE retail_price <> ROUND(retail_price, 2) OR total_price <> ROUND(total_price, 2)",
+
+    "UPDATE sales SET total_amount = ROUND(total_amount, 2), final_amount = ROUND(final_amount, 2) "
+    "WHERE total_amount <> ROUND(total_amount, 2) OR final_amount <> ROUND(final_amount, 2)",
+
+    "DROP TRIGGER IF EXISTS calculate_supply_total_amount",
+    "DROP TRIGGER IF EXISTS calculate_sale_final_amount",
+    "DROP TRIGGER IF EXISTS calculate_sale_item_total_price",
+    "DROP TRIGGER IF EXISTS update_sale_total_amount",
+    "DROP TRIGGER IF EXISTS update_sale_total_amount_on_delete",
+
+    "CREATE TRIGGER IF NOT EXISTS calculate_supply_total_amount "
+    "AFTER INSERT ON supplies "
+    "WHEN NEW.total_amount IS NULL "
+    "BEGIN "
+    "UPDATE supplies "
+    "SET total_amount = ROUND(NEW.quantity * NEW.purchase_price, 2) "
+    "WHERE id = NEW.id; "
+    "END",
+
+    // Скидка округляется отдельно и вычитается, как в Money::discounted()
+    "CREATE TRIGGER IF NOT EXISTS calculate_sale_final_amount "
+    "AFTER INSERT ON sales "
+    "BEGIN "
+    "UPDATE sales "
+    "SET final_amount = NEW.total_amount - ROUND(NEW.total_amount * COALESCE(NEW.discount_amount, 0) / 100.0, 2) "
+    "WHERE id = NEW.id; "
+    "END",
+
+    "CREATE TRIGGER IF NOT EXISTS calculate_sale_item_total_price "
+    "AFTER INSERT ON sale_items "
+    "WHEN NEW.total_price IS NULL "
+    "BEGIN "
+    "UPDATE sale_items "
+    "SET total_price = ROUND(NEW.quantity * NEW.retail_price, 2) "
+    "WHERE id = NEW.id; "
+    "END",
+
+    "CREATE TRIGGER IF NOT EXISTS update_sale_total_amount "
+    "AFTER INSERT ON sale_items "
+    "BEGIN "
+    "UPDATE sales "
+    "SET total_amount = ROUND((SELECT COALESCE(SUM(total_price), 0) FROM sale_items WHERE sale_id = NEW.sale_id), 2) "
+    "WHERE id = NEW.sale_id; "
+    "END",
+
+    "CREATE TRIGGER IF NOT EXISTS update_sale_total_amount_on_delete "
+    "AFTER DELETE ON sale_items "
+    "BEGIN "
+    "UPDATE sales "
+    "SET total_amount = ROUND((SELECT COALESCE(SUM(total_price), 0) FROM sale_items WHERE sale_id = OLD.sale_id), 2) "
+    "WHERE id = OLD.sale_id; "
+    "END"
+};
+
+// Версия 7: скидки считает PromotionEngine по правилам из таблицы promotions.
+// Итог продажи приходит из приложения, триггер считает его только для старых
+// клиентов, которые final_amount не передают.
+static const char *const promotionsMigration[] = {
+    "CREATE TABLE IF NOT EXISTS promotions ("
+    "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+    "name TEXT NOT NULL, "
+    "kind TEXT NOT NULL CHECK (kind IN ('quantity', 'category', 'bundle')), "
+    "percent REAL NOT NULL CHECK (percent > 0 AND percent <= 100), "
+    "min_quantity INTEGER NOT NULL DEFAULT 1, "
+    "category_id INTEGER, "
+    "product_id INTEGER, "
+    "bundle_product_id INTEGER, "
+    "valid_from TIMESTAMP, "
+    "valid_to TIMESTAMP, "
+    "hour_from INTEGER CHECK (hour_from BETWEEN 0 AND 23), "
+    "hour_to INTEGER CHECK (hour_to BETWEEN 0 AND 24), "
+    "active INTEGER NOT NULL DEFAULT 1, "
+    "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP, "
+    "FOREIGN KEY (category_id) REFERENCES product_categories(id) ON DELETE CASCADE, "
+    "FOREIGN KEY (product_id) REFERENCES products(id) ON DELETE CASCADE, "
+    "FOREIGN KEY (bundle_product_id) REFERENCES products(id) ON DELETE CASCADE)",
+
+    // Прежние ступени скидки корзины клиента
+    "INSERT INTO promotions (name, kind, percent, min_quantity) VALUES "
+    "('От 3 товаров', 'quantity', 5, 3), "
+    "('От 6 товаров', 'quantity', 10, 6)",
+
+    "DROP TRIGGER IF EXISTS calculate_sale_final_amount",
+
+    "CREATE TRIGGER IF NOT EXISTS calculate_sale_final_amount "
+    "AFTER INSERT ON sales "
+    "WHEN NEW.final_amount IS NULL "
+    "BEGIN "
+    "UPDATE sales "
+    "SET final_amount = NEW.total_amount - ROUND(NEW.total_amount * COALESCE(NEW.discount_amount, 0) / 100.0, 2) "
+    "WHERE id = NEW.id; "
+    "END"
+};
+
+// Версия 8: прайс-листы с интервалом действия. Пока интервал идет,
+// цена из прайс-листа заменяет products.retail_price, см. PriceIndex.
+static const char *const priceListMigration[] = {
+    "CREATE TABLE IF NOT EXISTS price_lists ("
+    "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+    "name TEXT NOT NULL, "
+    "valid_from TIMESTAMP NOT NULL, "
+    "valid_to TIMESTAMP, "
+    "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP, "
+    "CHECK (valid_to IS NULL OR valid_to > valid_from))",
+
+    "CREATE TABLE IF NOT EXISTS price_list_items ("
+    "price_list_id INTEGER NOT NULL, "
+    "product_id INTEGER NOT NULL, "
+    "retail_price REAL NOT NULL CHECK (retail_price >= 0), "
+    "PRIMARY KEY (price_list_id, product_id), "
+    "FOREIGN KEY (price_list_id) REFERENCES price_lists(id) ON DELETE CASCADE, "
+    "FOREIGN KEY (product_id) REFERENCES products(id) ON DELETE CASCADE)",
+
+    "CREATE INDEX IF NOT EXISTS idx_price_lists_valid_to ON price_lists(valid_to)"
+};
+
+// Документ поставки объединяет строки supplies; движения по его строкам
+// пишутся одним запросом, поэтому построчный триггер их пропускает
+static const char *const supplyDocumentsMigration[] = {
+    "CREATE TABLE IF NOT EXISTS supply_documents ("
+    "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+    "document_number TEXT UNIQUE NOT NULL, "
+    "supplier_name TEXT NOT NULL, "
+    "supply_date TIMESTAMP DEFAULT CURRENT_TIMESTAMP, "
+    "created_by INTEGER NOT NULL, "
+    "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP, "
+    "FOREIGN KEY (created_by) REFERENCES users(id))",
+
+    "ALTER TABLE supplies ADD COLUMN document_id INTEGER REFERENCES supply_documents(id)",
+
+    "CREATE INDEX IF NOT EXISTS idx_supplies_document ON supplies(document_id)",
+
+    "DROP TRIGGER IF EXISTS record_supply_movement",
+
+    "CREATE TRIGGER IF NOT EXISTS record_supply_movement "
+    "AFTER INSERT ON supplies "
+    "FOR EACH ROW "
+    "WHEN NEW.document_id IS NULL "
+    "BEGIN "
+    "INSERT INTO stock_movements (product_id, quantity, reason, reference_id) "
+    "VALUES (NEW.product_id, NEW.quantity, 'supply', NEW.id); "
+    "END"
+};
+
+// Индексы для поиска товара по началу названия или артикула: LIKE 'abc%'
+// без учета регистра идет по индексу только с правилом сравнения NOCASE
+static const char *const productSearchMigration[] = {
+    "CREATE INDEX IF NOT EXISTS idx_products_name_nocase ON products(name COLLATE NOCASE)",
+    "CREATE INDEX IF NOT EXISTS idx_products_article_nocase ON products(article COLLATE NOCASE)"
+};
+
+// Таблицы архивного файла: те же колонки, что в основной базе, без триггеров
+static const char *const archiveSchema[] = {
+    "CREATE TABLE IF NOT EXISTS %1.sales ("
+    "id INTEGER PRIMARY KEY, "
+    "receipt_number TEXT NOT NULL, "
+    "sale_date TIMESTAMP, "
+    "cashier_id INTEGER, "
+    "customer_id INTEGER, "
+    "total_amount REAL, "
+    "discount_amount REAL, "
+    "final_amount REAL, "
+    "created_at TIMESTAMP)",
+
+    "CREATE TABLE IF NOT EXISTS %1.sale_items ("
+    "id INTEGER PRIMARY KEY, "
+    "sale_id INTEGER NOT NULL, "
+    "product_id INTEGER NOT NULL, "
+    "quantity INTEGER NOT NULL, "
+    "retail_price REAL NOT NULL, "
+    "total_price REAL)",
+
+    "CREATE INDEX IF NOT EXISTS %1.idx_sales_date ON sales(sale_date)",
+    "CREATE INDEX IF NOT EXISTS %1.idx_sales_cashier ON sales(cashier_id)",
+    "CREATE INDEX IF NOT EXISTS %1.idx_sale_items_sale ON sale_items(sale_id)"
+};
+
+static QAtomicInteger<qint64> committedTransactions;
+static QAtomicInteger<qint64> transactionRetries;
+static QAtomicInteger<qint64> failedTransactions;
 
 Database::Database(QObject *parent) : QObject(parent)
 {
+    // У каждого экземпляра свое соединение: экземпляры живут одновременно
+    // и могут работать из разных потоков
+    connectionName = QString("shop_connection_%1").arg(connectionCounter.fetchAndAddRelaxed(1));
 }
 
 Database::~Database()
@@ -11,6 +364,12 @@ Database::~Database()
     {
         db.close();
     }
+
+    db = QSqlDatabase();
+    if (QSqlDatabase::contains(connectionName))
+    {
+        QSqlDatabase::removeDatabase(connectionName);
+    }
 }
 
 static QString hashPassword(const QString &password)
@@ -64,9 +423,18 @@ bool Database::connectToDatabase(const QString &dbName)
     {
         db.close();
     }
+    archiveYears.clear();
 
-    db = QSqlDatabase::addDatabase("QSQLITE", "shop_connection");
+    if (QSqlDatabase::contains(connectionName))
+    {
+        db = QSqlDatabase::database(connectionName, false);
+    }
+    else
+    {
+        db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    }
     db.setDatabaseName(dbName);
+    db.setConnectOptions(QString("QSQLITE_BUSY_TIMEOUT=%1").arg(BUSY_TIMEOUT_MS));
 
     if (!db.open())
     {
@@ -74,12 +442,169 @@ bool Database::connectToDatabase(const QString &dbName)
         return false;
     }
 
+    if (!migrateSchema())
+    {
+        qDebug() << "Ошибка обновления схемы базы данных:" << lastSqlError.text();
+        db.close();
+        return false;
+    }
+
     qDebug() << "Successfully connected to database:" << dbName;
     return true;
 }
 
+bool Database::migrateSchema()
+{
+    QSqlQuery query(db);
+    if (!executeQuery(query, "PRAGMA user_version") || !query.next())
+    {
+        return false;
+    }
+
+    if (query.value(0).toInt() >= SCHEMA_VERSION)
+    {
+        return true;
+    }
+
+    return runInTransaction([&]() {
+        // Другое соединение могло обновить схему, пока ждали блокировку
+        QSqlQuery query(db);
+        if (!executeQuery(query, "PRAGMA user_version") || !query.next())
+        {
+            return false;
+        }
+
+        int version = query.value(0).toInt();
+
+        if (version < 1)
+        {
+            bool hasVersionColumn = false;
+            if (!executeQuery(query, "PRAGMA table_info(products)"))
+            {
+                return false;
+            }
+            while (query.next())
+            {
+                if (query.value(1).toString() == "version")
+                {
+                    hasVersionColumn = true;
+                }
+            }
+
+            if (!hasVersionColumn
+                && !executeQuery(query, "ALTER TABLE products ADD COLUMN version INTEGER NOT NULL DEFAULT 1"))
+            {
+                return false;
+            }
+        }
+
+        if (version < 2)
+        {
+            for (const char *statement : stockLedgerMigration)
+            {
+                if (!executeQuery(query, QString::fromUtf8(statement)))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (version < 3)
+        {
+            for (const char *statement : reconciliationIndexMigration)
+            {
+                if (!executeQuery(query, QString::fromUtf8(statement)))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (version < 4)
+        {
+            for (const char *statement : archiveMigration)
+            {
+                if (!executeQuery(query, QString::fromUtf8(statement)))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (version < 5)
+        {
+            for (const char *statement : supplyTotalMigration)
+            {
+                if (!executeQuery(query, QString::fromUtf8(statement)))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (version < 6)
+        {
+            for (const char *statement : moneyRoundingMigration)
+            {
+                if (!executeQuery(query, QString::fromUtf8(statement)))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (version < 7)
+        {
+            for (const char *statement : promotionsMigration)
+            {
+                if (!executeQuery(query, QString::fromUtf8(statement)))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (version < 8)
+        {
+            for (const char *statement : priceListMigration)
+            {
+                if (!executeQuery(query, QString::fromUtf8(statement)))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (version < 9)
+        {
+            for (const char *statement : supplyDocumentsMigration)
+            {
+                if (!executeQuery(query, QString::fromUtf8(statement)))
+                {
+                    return false;
+                }
+            }
+        }
+
+        if (version < 10)
+        {
+            for (const char *statement : productSearchMigration)
+            {
+                if (!executeQuery(query, QString::fromUtf8(statement)))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return executeQuery(query, QString("PRAGMA user_version = %1").arg(SCHEMA_VERSION));
+    });
+}
+
 bool Database::executeQuery(QSqlQuery &query, const QString &queryText)
 {
+    lastSqlError = QSqlError();
+
     try
     {
         bool result;
@@ -94,7 +619,8 @@ bool Database::executeQuery(QSqlQuery &query, const QString &queryText)
 
         if (!result)
         {
-            QString errorText = query.lastError().text();
+            lastSqlError = query.lastError();
+            QString errorText = lastSqlError.text();
             qDebug() << "Ошибка SQL:" << errorText;
 
             return false;
@@ -114,6 +640,11 @@ bool Database::executeQuery(QSqlQuery &query, const QString &queryText)
     }
 }
 
+QSqlError Database::lastError() const
+{
+    return lastSqlError;
+}
+
 QSqlQuery Database::prepareQuery(const QString &queryText)
 {
     QSqlQuery query(db);
@@ -121,6 +652,88 @@ QSqlQuery Database::prepareQuery(const QString &queryText)
     return query;
 }
 
+bool Database::isBusyError(const QSqlError &error)
+{
+    // SQLITE_BUSY = 5, SQLITE_LOCKED = 6
+    return error.nativeErrorCode() == "5"
+           || error.nativeErrorCode() == "6"
+           || error.text().contains("database is locked", Qt::CaseInsensitive);
+}
+
+TransactionStats Database::transactionStats()
+{
+    TransactionStats stats;
+    stats.transactions = committedTransactions.loadRelaxed();
+    stats.retries = transactionRetries.loadRelaxed();
+    stats.failures = failedTransactions.loadRelaxed();
+    return stats;
+}
+
+void Database::resetTransactionStats()
+{
+    committedTransactions.storeRelaxed(0);
+    transactionRetries.storeRelaxed(0);
+    failedTransactions.storeRelaxed(0);
+}
+
+bool Database::runInTransaction(const std::function<bool()> &body)
+{
+    for (int attempt = 0; ; attempt++)
+    {
+        // BEGIN IMMEDIATE берет блокировку записи сразу, поэтому конфликт
+        // проявляется до первых изменений, а не на COMMIT
+        QSqlQuery query(db);
+        bool success = executeQuery(query, "BEGIN IMMEDIATE");
+
+        if (success)
+        {
+            try
+            {
+                success = body();
+            }
+            catch (const std::exception &e)
+            {
+                qDebug() << "Исключение в транзакции:" << e.what();
+                success = false;
+            }
+            catch (...)
+            {
+                qDebug() << "Неизвестное исключение в транзакции";
+                success = false;
+            }
+
+            if (success)
+            {
+                success = executeQuery(query, "COMMIT");
+            }
+
+            if (!success)
+            {
+                QSqlError error = lastSqlError;
+                QSqlQuery(db).exec("ROLLBACK");
+                lastSqlError = error;
+            }
+        }
+
+        if (success)
+        {
+            committedTransactions.fetchAndAddRelaxed(1);
+            return true;
+        }
+
+        if (!isBusyError(lastSqlError) || attempt + 1 >= MAX_TRANSACTION_ATTEMPTS)
+        {
+            failedTransactions.fetchAndAddRelaxed(1);
+            return false;
+        }
+
+        transactionRetries.fetchAndAddRelaxed(1);
+
+        int delayMs = qMin(RETRY_BASE_DELAY_MS << attempt, RETRY_MAX_DELAY_MS);
+        QThread::msleep(static_cast<unsigned long>(delayMs / 2 + QRandomGenerator::global()->bounded(delayMs / 2 + 1)));
+    }
+}
+
 User Database::authenticateUser(const QString &login, const QString &password)
 {
     User user;
@@ -156,10 +769,10 @@ QList<Product> Database::getAllProducts()
     QList<Product> products;
 
     QSqlQuery query = prepareQuery(
-        "SELECT p.id, p.article, p.name, p.category_id, pc.name, "
-        "p.purchase_price, p.retail_price, p.stock, p.created_at, p.updated_at "
+        "SELECT p.id, p.article, p.name, p.category_id, "
+        "p.purchase_price, p.retail_price, ps.stock, p.created_at, p.updated_at, p.version "
         "FROM products p "
-        "LEFT JOIN product_categories pc ON p.category_id = pc.id "
+        "JOIN product_stock ps ON ps.product_id = p.id "
         "ORDER BY p.name");
 
     if (!executeQuery(query, ""))
@@ -174,12 +787,12 @@ QList<Product> Database::getAllProducts()
         product.article = query.value(1).toString();
         product.name = query.value(2).toString();
         product.categoryId = query.value(3).toInt();
-        product.categoryName = query.value(4).toString();
-        product.purchasePrice = query.value(5).toDouble();
-        product.retailPrice = query.value(6).toDouble();
-        product.stock = query.value(7).toInt();
-        product.createdAt = query.value(8).toDateTime();
-        product.updatedAt = query.value(9).toDateTime();
+        product.purchasePrice = query.value(4).toDouble();
+        product.retailPrice = query.value(5).toDouble();
+        product.stock = query.value(6).toInt();
+        product.createdAt = query.value(7).toDateTime();
+        product.updatedAt = query.value(8).toDateTime();
+        product.version = query.value(9).toInt();
 
         products.append(product);
     }
@@ -268,220 +881,1329 @@ QList<Sale> Database::getAllSales()
 
 bool Database::addProduct(const Product &product)
 {
-    QSqlQuery query = prepareQuery(
-        "INSERT INTO products (article, name, category_id, purchase_price, retail_price, stock) "
-        "VALUES (:article, :name, :category_id, :purchase_price, :retail_price, :stock)");
+    bool success = runInTransaction([&]() {
+        QSqlQuery query = prepareQuery(
+            "INSERT INTO products (article, name, category_id, purchase_price, retail_price) "
+            "VALUES (:article, :name, :category_id, :purchase_price, :retail_price)");
 
-    query.bindValue(":article", product.article);
-    query.bindValue(":name", product.name);
-    query.bindValue(":category_id", product.categoryId > 0 ? product.categoryId : QVariant());
-    query.bindValue(":purchase_price", product.purchasePrice);
-    query.bindValue(":retail_price", product.retailPrice);
-    query.bindValue(":stock", product.stock);
+        query.bindValue(":article", product.article);
+        query.bindValue(":name", product.name);
+        query.bindValue(":category_id", product.categoryId > 0 ? product.categoryId : QVariant());
+        query.bindValue(":purchase_price", product.purchasePrice);
+        query.bindValue(":retail_price", product.retailPrice);
 
-    return executeQuery(query, "");
+        if (!executeQuery(query, ""))
+        {
+            return false;
+        }
+
+        return addStockMovement(query.lastInsertId().toInt(), product.stock, "initial");
+    });
+
+    if (success)
+    {
+        CatalogEvents::instance().notifyProductsChanged();
+    }
+
+    return success;
 }
 
-bool Database::updateProduct(const Product &product)
+Database::UpdateResult Database::updateProduct(const Product &product, int stockDelta)
 {
-    QSqlQuery query = prepareQuery(
-        "UPDATE products SET "
-        "article = :article, name = :name, category_id = :category_id, "
-        "purchase_price = :purchase_price, retail_price = :retail_price, stock = :stock "
-        "WHERE id = :id");
-
-    query.bindValue(":id", product.id);
-    query.bindValue(":article", product.article);
-    query.bindValue(":name", product.name);
-    query.bindValue(":category_id", product.categoryId > 0 ? product.categoryId : QVariant());
-    query.bindValue(":purchase_price", product.purchasePrice);
-    query.bindValue(":retail_price", product.retailPrice);
-    query.bindValue(":stock", product.stock);
+    UpdateResult result = UpdateFailed;
 
-    return executeQuery(query, "");
+    runInTransaction([&]() {
+        // Запись применяется, только если товар не менялся с момента чтения;
+        // остаток меняется движением на разницу, чтобы не затереть параллельные продажи
+        QSqlQuery query = prepareQuery(
+            "UPDATE products SET "
+            "article = :article, name = :name, category_id = :category_id, "
+            "purchase_price = :purchase_price, retail_price = :retail_price, "
+            "version = version + 1, updated_at = CURRENT_TIMESTAMP "
+            "WHERE id = :id AND version = :version");
+
+        query.bindValue(":id", product.id);
+        query.bindValue(":version", product.version);
+        query.bindValue(":article", product.article);
+        query.bindValue(":name", product.name);
+        query.bindValue(":category_id", product.categoryId > 0 ? product.categoryId : QVariant());
+        query.bindValue(":purchase_price", product.purchasePrice);
+        query.bindValue(":retail_price", product.retailPrice);
+
+        if (!executeQuery(query, ""))
+        {
+            result = UpdateFailed;
+            return false;
+        }
+
+        if (query.numRowsAffected() == 0)
+        {
+            result = UpdateConflict;
+            return false;
+        }
+
+        if (!addStockMovement(product.id, stockDelta, "adjustment"))
+        {
+            result = UpdateFailed;
+            return false;
+        }
+
+        result = UpdateOk;
+        return true;
+    });
+
+    if (result == UpdateOk)
+    {
+        CatalogEvents::instance().notifyProductsChanged();
+    }
+
+    return result;
 }
 
 bool Database::deleteProduct(int productId)
 {
-    QSqlQuery query = prepareQuery("DELETE FROM products WHERE id = :id");
-    query.bindValue(":id", productId);
+    bool success = runInTransaction([&]() {
+        QSqlQuery query = prepareQuery("DELETE FROM products WHERE id = :id");
+        query.bindValue(":id", productId);
 
-    return executeQuery(query, "");
+        return executeQuery(query, "");
+    });
+
+    if (success)
+    {
+        CatalogEvents::instance().notifyProductsChanged();
+    }
+
+    return success;
 }
 
-bool Database::addSupply(const Supply &supply, int userId)
+QString Database::productFilterClause(const ProductFilter &filter)
 {
-    try
+    QStringList conditions;
+
+    if (filter.categoryId == 0)
+    {
+        conditions << "category_id IS NULL";
+    }
+    else if (filter.categoryId > 0)
     {
-        db.transaction();
+        conditions << "category_id = :filter_category_id";
+    }
 
-        QSqlQuery query = prepareQuery(
-            "INSERT INTO supplies (supply_number, supplier_name, product_id, quantity, "
-            "purchase_price, supply_date, created_by) "
-            "VALUES (:supply_number, :supplier_name, :product_id, :quantity, "
-            ":purchase_price, :supply_date, :created_by)");
+    if (!filter.text.isEmpty())
+    {
+        conditions << "(name LIKE :filter_name ESCAPE '\\' OR article LIKE :filter_article ESCAPE '\\')";
+    }
 
-        query.bindValue(":supply_number", supply.supplyNumber);
-        query.bindValue(":supplier_name", supply.supplierName);
-        query.bindValue(":product_id", supply.productId);
-        query.bindValue(":quantity", supply.quantity);
-        query.bindValue(":purchase_price", supply.purchasePrice);
-        query.bindValue(":supply_date", supply.supplyDate);
-        query.bindValue(":created_by", userId);
+    // Выделение из таблицы - целые числа, их можно подставить в текст запроса
+    if (!filter.productIds.isEmpty())
+    {
+        QStringList ids;
+        ids.reserve(filter.productIds.size());
+        for (int productId : filter.productIds)
+        {
+            ids << QString::number(productId);
+        }
+        conditions << QString("id IN (%1)").arg(ids.join(','));
+    }
+
+    return conditions.isEmpty() ? QString() : " WHERE " + conditions.join(" AND ");
+}
+
+void Database::bindProductFilter(QSqlQuery &query, const ProductFilter &filter)
+{
+    if (filter.categoryId > 0)
+    {
+        query.bindValue(":filter_category_id", filter.categoryId);
+    }
+
+    if (!filter.text.isEmpty())
+    {
+        QString escaped = filter.text;
+        escaped.replace('\\', "\\\\").replace('%', "\\%").replace('_', "\\_");
+        QString pattern = "%" + escaped + "%";
+        query.bindValue(":filter_name", pattern);
+        query.bindValue(":filter_article", pattern);
+    }
+}
+
+int Database::countProducts(const ProductFilter &filter)
+{
+    QSqlQuery query = prepareQuery("SELECT COUNT(*) FROM products" + productFilterClause(filter));
+    bindProductFilter(query, filter);
+
+    if (!executeQuery(query, "") || !query.next())
+    {
+        return -1;
+    }
+
+    return query.value(0).toInt();
+}
+
+int Database::bulkChangePrice(const ProductFilter &filter, PriceColumn column, PriceChange change, double value)
+{
+    QString field = column == RetailPrice ? "retail_price" : "purchase_price";
+    QString expression = change == ChangePercent
+                             ? QString("%1 * (1 + :value / 100.0)").arg(field)
+                             : QString("%1 + :value").arg(field);
+
+    // Одна команда на все строки: цена не уходит ниже нуля и округляется до копеек,
+    // версия растет, чтобы открытые формы редактирования увидели конфликт
+    QString queryText = QString(
+        "UPDATE products SET %1 = ROUND(MAX(0, %2), 2), "
+        "version = version + 1, updated_at = CURRENT_TIMESTAMP")
+        .arg(field, expression) + productFilterClause(filter);
+
+    int affected = -1;
+
+    bool success = runInTransaction([&]() {
+        QSqlQuery query = prepareQuery(queryText);
+        query.bindValue(":value", value);
+        bindProductFilter(query, filter);
+
+        if (!executeQuery(query, ""))
+        {
+            return false;
+        }
+
+        affected = query.numRowsAffected();
+        return true;
+    });
+
+    if (!success)
+    {
+        return -1;
+    }
+
+    CatalogEvents::instance().notifyProductsChanged();
+    return affected;
+}
+
+int Database::bulkMoveCategory(const ProductFilter &filter, int categoryId)
+{
+    QString queryText =
+        "UPDATE products SET category_id = :category_id, "
+        "version = version + 1, updated_at = CURRENT_TIMESTAMP" + productFilterClause(filter);
+
+    int affected = -1;
+
+    bool success = runInTransaction([&]() {
+        QSqlQuery query = prepareQuery(queryText);
+        query.bindValue(":category_id", categoryId > 0 ? categoryId : QVariant());
+        bindProductFilter(query, filter);
 
         if (!executeQuery(query, ""))
         {
-            db.rollback();
             return false;
         }
 
-        db.commit();
+        affected = query.numRowsAffected();
+        return true;
+    });
+
+    if (!success)
+    {
+        return -1;
+    }
+
+    CatalogEvents::instance().notifyProductsChanged();
+    return affected;
+}
+
+bool Database::addStockMovement(int productId, int quantity, const QString &reason, const QVariant &referenceId)
+{
+    if (quantity == 0)
+    {
         return true;
     }
-    catch (const std::exception &e)
+
+    QSqlQuery query = prepareQuery(
+        "INSERT INTO stock_movements (product_id, quantity, reason, reference_id) "
+        "VALUES (:product_id, :quantity, :reason, :reference_id)");
+
+    query.bindValue(":product_id", productId);
+    query.bindValue(":quantity", quantity);
+    query.bindValue(":reason", reason);
+    query.bindValue(":reference_id", referenceId);
+
+    return executeQuery(query, "");
+}
+
+QList<StockMovement> Database::getStockMovements(int productId)
+{
+    QList<StockMovement> movements;
+
+    QSqlQuery query = prepareQuery(
+        "SELECT id, product_id, quantity, reason, reference_id, created_at "
+        "FROM stock_movements "
+        "WHERE product_id = :product_id "
+        "ORDER BY id DESC");
+
+    query.bindValue(":product_id", productId);
+
+    if (!executeQuery(query, ""))
+    {
+        return movements;
+    }
+
+    while (query.next())
+    {
+        StockMovement movement;
+        movement.id = query.value(0).toLongLong();
+        movement.productId = query.value(1).toInt();
+        movement.quantity = query.value(2).toInt();
+        movement.reason = query.value(3).toString();
+        movement.referenceId = query.value(4).isNull() ? -1 : query.value(4).toInt();
+        movement.createdAt = query.value(5).toDateTime();
+
+        movements.append(movement);
+    }
+
+    return movements;
+}
+
+bool Database::createStockSnapshots(int minTail)
+{
+    // Снимок фиксирует остаток на последнем движении, после него
+    // product_stock суммирует только хвост журнала. Переписываются только
+    // товары, у которых с прошлого снимка накопилось не меньше minTail движений
+    return runInTransaction([&]() {
+        QSqlQuery query = prepareQuery(
+            "INSERT OR REPLACE INTO stock_snapshots (product_id, stock, movement_id, created_at) "
+            "SELECT ps.product_id, ps.stock, "
+            "(SELECT COALESCE(MAX(id), 0) FROM stock_movements), CURRENT_TIMESTAMP "
+            "FROM product_stock ps "
+            "LEFT JOIN stock_snapshots s ON s.product_id = ps.product_id "
+            "WHERE (SELECT COUNT(*) FROM stock_movements m "
+            "WHERE m.product_id = ps.product_id AND m.id > COALESCE(s.movement_id, 0)) >= :min_tail");
+
+        query.bindValue(":min_tail", qMax(minTail, 1));
+
+        return executeQuery(query, "");
+    });
+}
+
+QString Database::stockCheckQueryText()
+{
+    // Ожидаемый остаток не зависит от журнала продаж и корзин: ручные движения
+    // плюс поставки минус проданное (включая архив) минус зарезервированное в корзинах
+    return "SELECT p.id, p.name, ps.stock, "
+           "COALESCE((SELECT SUM(m.quantity) FROM stock_movements m "
+           "WHERE m.product_id = p.id AND m.reason IN ('initial', 'adjustment', 'reconcile')), 0) "
+           "+ COALESCE((SELECT SUM(su.quantity) FROM supplies su WHERE su.product_id = p.id), 0) "
+           "- COALESCE((SELECT SUM(si.quantity) FROM sale_items si WHERE si.product_id = p.id), 0) "
+           "- COALESCE((SELECT ast.quantity FROM archived_sale_totals ast WHERE ast.product_id = p.id), 0) "
+           "- COALESCE((SELECT SUM(ci.quantity) FROM cart_items ci WHERE ci.product_id = p.id), 0) "
+           "FROM products p "
+           "JOIN product_stock ps ON ps.product_id = p.id "
+           "WHERE p.id BETWEEN :first_id AND :last_id";
+}
+
+bool Database::getProductIdRange(int &minId, int &maxId)
+{
+    QSqlQuery query = prepareQuery("SELECT COALESCE(MIN(id), 0), COALESCE(MAX(id), -1) FROM products");
+
+    if (!executeQuery(query, "") || !query.next())
+    {
+        return false;
+    }
+
+    minId = query.value(0).toInt();
+    maxId = query.value(1).toInt();
+    return true;
+}
+
+int Database::reconcileStock(const QList<int> &productIds)
+{
+    int repaired = 0;
+
+    bool success = runInTransaction([&]() {
+        repaired = 0;
+
+        // Расхождение пересчитывается под блокировкой записи: между проверкой
+        // и исправлением остаток мог измениться продажами
+        QSqlQuery query = prepareQuery(stockCheckQueryText());
+
+        for (int productId : productIds)
+        {
+            query.bindValue(":first_id", productId);
+            query.bindValue(":last_id", productId);
+
+            if (!executeQuery(query, ""))
+            {
+                return false;
+            }
+
+            if (!query.next())
+            {
+                continue;
+            }
+
+            int delta = query.value(3).toInt() - query.value(2).toInt();
+            query.finish();
+
+            if (delta != 0)
+            {
+                if (!addStockMovement(productId, delta, "reconcile"))
+                {
+                    return false;
+                }
+                repaired++;
+            }
+        }
+
+        return true;
+    });
+
+    return success ? repaired : -1;
+}
+
+bool Database::addSupply(const Supply &supply, int userId)
+{
+    bool success = runInTransaction([&]() {
+        QSqlQuery query = prepareQuery(
+            "INSERT INTO supplies (supply_number, supplier_name, product_id, quantity, "
+            "purchase_price, supply_date, created_by) "
+            "VALUES (:supply_number, :supplier_name, :product_id, :quantity, "
+            ":purchase_price, :supply_date, :created_by)");
+
+        query.bindValue(":supply_number", supply.supplyNumber);
+        query.bindValue(":supplier_name", supply.supplierName);
+        query.bindValue(":product_id", supply.productId);
+        query.bindValue(":quantity", supply.quantity);
+        query.bindValue(":purchase_price", supply.purchasePrice);
+        query.bindValue(":supply_date", supply.supplyDate);
+        query.bindValue(":created_by", userId);
+
+        return executeQuery(query, "");
+    });
+
+    if (!success)
+    {
+        qDebug() << "Ошибка при добавлении поставки:" << lastSqlError.text();
+    }
+
+    return success;
+}
+
+bool Database::addSupplyDocument(SupplyDocument &document, int userId)
+{
+    int documentId = -1;
+
+    bool success = runInTransaction([&]() {
+        QSqlQuery query = prepareQuery(
+            "INSERT INTO supply_documents (document_number, supplier_name, supply_date, created_by) "
+            "VALUES (:document_number, :supplier_name, :supply_date, :created_by)");
+
+        query.bindValue(":document_number", document.documentNumber);
+        query.bindValue(":supplier_name", document.supplierName);
+        query.bindValue(":supply_date", document.supplyDate);
+        query.bindValue(":created_by", userId);
+
+        if (!executeQuery(query, ""))
+        {
+            return false;
+        }
+
+        documentId = query.lastInsertId().toInt();
+
+        // Один подготовленный запрос на все строки документа
+        QSqlQuery lineQuery = prepareQuery(
+            "INSERT INTO supplies (supply_number, supplier_name, product_id, quantity, "
+            "purchase_price, total_amount, supply_date, created_by, document_id) "
+            "VALUES (:supply_number, :supplier_name, :product_id, :quantity, "
+            ":purchase_price, :total_amount, :supply_date, :created_by, :document_id)");
+
+        for (int i = 0; i < document.lines.size(); i++)
+        {
+            const Supply &line = document.lines[i];
+            Money price = Money::fromDouble(line.purchasePrice);
+
+            lineQuery.bindValue(":supply_number",
+                                QString("%1-%2").arg(document.documentNumber).arg(i + 1, 3, 10, QChar('0')));
+            lineQuery.bindValue(":supplier_name", document.supplierName);
+            lineQuery.bindValue(":product_id", line.productId);
+            lineQuery.bindValue(":quantity", line.quantity);
+            lineQuery.bindValue(":purchase_price", price.toDouble());
+            lineQuery.bindValue(":total_amount", (price * line.quantity).toDouble());
+            lineQuery.bindValue(":supply_date", document.supplyDate);
+            lineQuery.bindValue(":created_by", userId);
+            lineQuery.bindValue(":document_id", documentId);
+
+            if (!executeQuery(lineQuery, ""))
+            {
+                return false;
+            }
+        }
+
+        // Остатки по всем строкам одним запросом вместо построчного триггера
+        QSqlQuery movementQuery = prepareQuery(
+            "INSERT INTO stock_movements (product_id, quantity, reason, reference_id) "
+            "SELECT product_id, quantity, 'supply', id FROM supplies WHERE document_id = :document_id");
+        movementQuery.bindValue(":document_id", documentId);
+
+        return executeQuery(movementQuery, "");
+    });
+
+    if (!success)
+    {
+        qDebug() << "Ошибка при проведении документа поставки:" << lastSqlError.text();
+        return false;
+    }
+
+    document.id = documentId;
+    return true;
+}
+
+bool Database::deleteSupply(int supplyId)
+{
+    return runInTransaction([&]() {
+        QSqlQuery query = prepareQuery("DELETE FROM supplies WHERE id = :id");
+        query.bindValue(":id", supplyId);
+
+        return executeQuery(query, "");
+    });
+}
+
+bool Database::importBatch(const QList<ImportRecord> &records, int userId,
+                           ImportBatchResult &result, QList<ImportRowError> &errors)
+{
+    QList<ImportRowError> batchErrors;
+    bool categoriesAdded = false;
+
+    bool success = runInTransaction([&]() {
+        result.productsInserted = 0;
+        result.productsUpdated = 0;
+        result.suppliesInserted = 0;
+        batchErrors.clear();
+        categoriesAdded = false;
+
+        // Запросы готовятся один раз на пакет и переиспользуются для каждой строки;
+        // ошибка в строке откатывает только ее оператор, а не всю транзакцию
+        QSqlQuery findProduct = prepareQuery("SELECT id FROM products WHERE article = :article");
+        QSqlQuery currentStock = prepareQuery("SELECT stock FROM product_stock WHERE product_id = :id");
+        QSqlQuery insertNew = prepareQuery(
+            "INSERT INTO products (article, name, category_id, purchase_price, retail_price) "
+            "VALUES (:article, :name, :category_id, :purchase_price, :retail_price)");
+        QSqlQuery updateExisting = prepareQuery(
+            "UPDATE products SET name = :name, category_id = :category_id, "
+            "purchase_price = :purchase_price, retail_price = :retail_price, "
+            "version = version + 1, updated_at = CURRENT_TIMESTAMP "
+            "WHERE id = :id");
+        QSqlQuery insertMovement = prepareQuery(
+            "INSERT INTO stock_movements (product_id, quantity, reason) "
+            "VALUES (:product_id, :quantity, :reason)");
+        QSqlQuery insertSupply = prepareQuery(
+            "INSERT INTO supplies (supply_number, supplier_name, product_id, quantity, "
+            "purchase_price, total_amount, supply_date, created_by) "
+            "VALUES (:supply_number, :supplier_name, :product_id, :quantity, "
+            ":purchase_price, :total_amount, :supply_date, :created_by)");
+        QSqlQuery insertCategory = prepareQuery("INSERT INTO product_categories (name) VALUES (:name)");
+
+        QHash<QString, int> categories;
+        QSqlQuery query(db);
+        if (!executeQuery(query, "SELECT id, name FROM product_categories"))
+        {
+            return false;
+        }
+        while (query.next())
+        {
+            categories.insert(query.value(1).toString(), query.value(0).toInt());
+        }
+
+        for (const ImportRecord &record : records)
+        {
+            int productId = record.productId;
+
+            if (productId <= 0)
+            {
+                findProduct.bindValue(":article", record.article);
+                if (!executeQuery(findProduct, ""))
+                {
+                    return false;
+                }
+                productId = findProduct.next() ? findProduct.value(0).toInt() : 0;
+                findProduct.finish();
+            }
+
+            if (record.kind == ImportRecord::SupplyRecord)
+            {
+                if (productId <= 0)
+                {
+                    batchErrors.append({record.line, QString("Товар с артикулом %1 не найден").arg(record.article)});
+                    continue;
+                }
+
+                insertSupply.bindValue(":supply_number", record.supplyNumber);
+                insertSupply.bindValue(":supplier_name", record.supplierName);
+                insertSupply.bindValue(":product_id", productId);
+                insertSupply.bindValue(":quantity", record.quantity);
+                insertSupply.bindValue(":purchase_price", record.purchasePrice);
+                insertSupply.bindValue(":total_amount", record.quantity * record.purchasePrice);
+                insertSupply.bindValue(":supply_date", record.supplyDate);
+                insertSupply.bindValue(":created_by", userId);
+
+                if (!executeQuery(insertSupply, ""))
+                {
+                    batchErrors.append({record.line, lastSqlError.databaseText()});
+                    continue;
+                }
+
+                result.suppliesInserted++;
+                continue;
+            }
+
+            QVariant categoryId;
+            if (!record.categoryName.isEmpty())
+            {
+                if (!categories.contains(record.categoryName))
+                {
+                    insertCategory.bindValue(":name", record.categoryName);
+                    if (!executeQuery(insertCategory, ""))
+                    {
+                        return false;
+                    }
+                    categories.insert(record.categoryName, insertCategory.lastInsertId().toInt());
+                    categoriesAdded = true;
+                }
+                categoryId = categories.value(record.categoryName);
+            }
+
+            QSqlQuery &write = productId > 0 ? updateExisting : insertNew;
+            if (productId > 0)
+            {
+                write.bindValue(":id", productId);
+            }
+            else
+            {
+                write.bindValue(":article", record.article);
+            }
+            write.bindValue(":name", record.name);
+            write.bindValue(":category_id", categoryId);
+            write.bindValue(":purchase_price", record.purchasePrice);
+            write.bindValue(":retail_price", record.retailPrice);
+
+            if (!executeQuery(write, ""))
+            {
+                batchErrors.append({record.line, lastSqlError.databaseText()});
+                continue;
+            }
+
+            // Остаток из файла - целевое значение: существующему товару
+            // пишется движение на разницу с текущим остатком
+            int stockDelta = 0;
+            QString reason = "adjustment";
+
+            if (productId > 0)
+            {
+                result.productsUpdated++;
+
+                if (record.stock >= 0)
+                {
+                    currentStock.bindValue(":id", productId);
+                    if (!executeQuery(currentStock, "") || !currentStock.next())
+                    {
+                        return false;
+                    }
+                    stockDelta = record.stock - currentStock.value(0).toInt();
+                    currentStock.finish();
+                }
+            }
+            else
+            {
+                result.productsInserted++;
+                productId = write.lastInsertId().toInt();
+                stockDelta = qMax(record.stock, 0);
+                reason = "initial";
+            }
+
+            if (stockDelta != 0)
+            {
+                insertMovement.bindValue(":product_id", productId);
+                insertMovement.bindValue(":quantity", stockDelta);
+                insertMovement.bindValue(":reason", reason);
+
+                if (!executeQuery(insertMovement, ""))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    });
+
+    if (!success)
+    {
+        qDebug() << "Ошибка импорта пакета:" << lastSqlError.text();
+        return false;
+    }
+
+    if (categoriesAdded)
+    {
+        CategoryCache::instance().invalidate();
+    }
+
+    if (result.productsInserted > 0 || result.productsUpdated > 0)
+    {
+        CatalogEvents::instance().notifyProductsChanged();
+    }
+
+    errors += batchErrors;
+    return true;
+}
+
+QString Database::exportQueryText(ExportTable table)
+{
+    // Выгрузка идет страницами по id: между страницами блокировка чтения
+    // снимается, и долгий экспорт не задерживает запись
+    switch (table)
+    {
+    case ExportProducts:
+        return "SELECT p.id, p.article, p.name, p.category_id, "
+               "p.purchase_price, p.retail_price, ps.stock, p.created_at, p.updated_at "
+               "FROM products p "
+               "JOIN product_stock ps ON ps.product_id = p.id "
+               "WHERE p.id > :after_id "
+               "ORDER BY p.id LIMIT :limit";
+    case ExportSupplies:
+        return "SELECT s.id, s.supply_number, s.supplier_name, p.name, "
+               "s.quantity, s.purchase_price, s.total_amount, s.supply_date, u.login, s.created_at "
+               "FROM supplies s "
+               "JOIN products p ON s.product_id = p.id "
+               "JOIN users u ON s.created_by = u.id "
+               "WHERE s.id > :after_id "
+               "ORDER BY s.id LIMIT :limit";
+    case ExportSales:
+        return "SELECT sa.id, sa.receipt_number, sa.sale_date, cashier.login, customer.login, "
+               "sa.total_amount, sa.discount_amount, sa.final_amount, sa.created_at "
+               "FROM sales sa "
+               "LEFT JOIN users cashier ON sa.cashier_id = cashier.id "
+               "LEFT JOIN users customer ON sa.customer_id = customer.id "
+               "WHERE sa.id > :after_id "
+               "ORDER BY sa.id LIMIT :limit";
+    }
+
+    return QString();
+}
+
+QString Database::exportCountQueryText(ExportTable table)
+{
+    switch (table)
+    {
+    case ExportProducts:
+        return "SELECT COUNT(*) FROM products";
+    case ExportSupplies:
+        return "SELECT COUNT(*) FROM supplies";
+    case ExportSales:
+        return "SELECT COUNT(*) FROM sales";
+    }
+
+    return QString();
+}
+
+Sale Database::getSaleDetails(int saleId)
+{
+    Sale sale;
+    sale.id = -1;
+
+    QString schema = findSaleSchema(saleId);
+    if (schema.isEmpty())
+    {
+        return sale;
+    }
+
+    QSqlQuery query = prepareQuery(QString(
+        "SELECT sa.id, sa.receipt_number, sa.sale_date, "
+        "sa.cashier_id, cashier.login, sa.customer_id, customer.login, "
+        "sa.total_amount, sa.discount_amount, sa.final_amount, sa.created_at "
+        "FROM %1.sales sa "
+        "LEFT JOIN main.users cashier ON sa.cashier_id = cashier.id "
+        "LEFT JOIN main.users customer ON sa.customer_id = customer.id "
+        "WHERE sa.id = :id").arg(schema));
+
+    query.bindValue(":id", saleId);
+
+    if (!executeQuery(query, ""))
+    {
+        return sale;
+    }
+
+    if (query.next())
+    {
+        sale.id = query.value(0).toInt();
+        sale.receiptNumber = query.value(1).toString();
+        sale.saleDate = query.value(2).toDateTime();
+        sale.cashierId = query.value(3).toInt();
+        sale.cashierName = query.value(4).toString();
+        sale.customerId = query.value(5).toInt();
+        sale.customerName = query.value(6).toString();
+        sale.totalAmount = query.value(7).toDouble();
+        sale.discountAmount = query.value(8).toDouble();
+        sale.finalAmount = query.value(9).toDouble();
+        sale.createdAt = query.value(10).toDateTime();
+    }
+
+    return sale;
+}
+
+QList<SaleItem> Database::getSaleItems(int saleId)
+{
+    QList<SaleItem> items;
+
+    QString schema = findSaleSchema(saleId);
+    if (schema.isEmpty())
+    {
+        return items;
+    }
+
+    QSqlQuery query = prepareQuery(QString(
+        "SELECT si.id, si.sale_id, si.product_id, p.name, "
+        "si.quantity, si.retail_price, si.total_price "
+        "FROM %1.sale_items si "
+        "JOIN main.products p ON si.product_id = p.id "
+        "WHERE si.sale_id = :sale_id").arg(schema));
+
+    query.bindValue(":sale_id", saleId);
+
+    if (!executeQuery(query, ""))
+    {
+        return items;
+    }
+
+    while (query.next())
+    {
+        SaleItem item;
+        item.id = query.value(0).toInt();
+        item.saleId = query.value(1).toInt();
+        item.productId = query.value(2).toInt();
+        item.productName = query.value(3).toString();
+        item.quantity = query.value(4).toInt();
+        item.retailPrice = query.value(5).toDouble();
+        item.totalPrice = query.value(6).toDouble();
+
+        items.append(item);
+    }
+
+    return items;
+}
+
+ProfitReport Database::generateProfitReport(const QDate &startDate, const QDate &endDate)
+{
+    ProfitReport report;
+    report.startDate = startDate;
+    report.endDate = endDate;
+    report.totalRevenue = 0;
+    report.totalCost = 0;
+    report.totalProfit = 0;
+
+    // Продажи периода могут лежать и в основной базе, и в архивах за эти годы
+    if (!attachArchiveYears(archiveYearsBetween(startDate.year(), endDate.year())))
+    {
+        return report;
+    }
+    QString source = saleLinesSource(startDate.year(), endDate.year());
+
+    QSqlQuery query = prepareQuery(QString(
+        "SELECT "
+        "SUM(si.total_price) as revenue, "
+        "SUM(si.quantity * p.purchase_price) as cost "
+        "FROM %1 si "
+        "JOIN products p ON si.product_id = p.id "
+        "WHERE DATE(si.sale_date) BETWEEN :start_date AND :end_date").arg(source));
+
+    query.bindValue(":start_date", startDate.toString("yyyy-MM-dd"));
+    query.bindValue(":end_date", endDate.toString("yyyy-MM-dd"));
+
+    if (executeQuery(query, "") && query.next())
+    {
+        report.totalRevenue = query.value(0).toDouble();
+        report.totalCost = query.value(1).toDouble();
+        report.totalProfit = report.totalRevenue - report.totalCost;
+    }
+
+    query = prepareQuery(QString(
+        "SELECT p.name, SUM(si.quantity) as total_quantity "
+        "FROM %1 si "
+        "JOIN products p ON si.product_id = p.id "
+        "WHERE DATE(si.sale_date) BETWEEN :start_date AND :end_date "
+        "GROUP BY p.id, p.name "
+        "ORDER BY total_quantity DESC "
+        "LIMIT 10").arg(source));
+
+    query.bindValue(":start_date", startDate.toString("yyyy-MM-dd"));
+    query.bindValue(":end_date", endDate.toString("yyyy-MM-dd"));
+
+    if (executeQuery(query, ""))
+    {
+        while (query.next())
+        {
+            report.popularProducts.append(
+                qMakePair(query.value(0).toString(), query.value(1).toInt()));
+        }
+    }
+
+    return report;
+}
+
+QString Database::archivePath(int year) const
+{
+    QFileInfo info(db.databaseName());
+    return info.absoluteDir().filePath(
+        QString("%1_archive_%2.db").arg(info.completeBaseName()).arg(year));
+}
+
+bool Database::attachArchive(int year)
+{
+    if (archiveYears.contains(year))
+    {
+        return true;
+    }
+
+    QSqlQuery query = prepareQuery(QString("ATTACH DATABASE :path AS archive_%1").arg(year));
+    query.bindValue(":path", archivePath(year));
+
+    if (!executeQuery(query, ""))
+    {
+        qDebug() << "Не удалось подключить архив продаж за" << year;
+        return false;
+    }
+
+    archiveYears.append(year);
+    std::sort(archiveYears.begin(), archiveYears.end());
+    return true;
+}
+
+bool Database::detachArchive(int year)
+{
+    QSqlQuery query(db);
+    if (!executeQuery(query, QString("DETACH DATABASE archive_%1").arg(year)))
+    {
+        qDebug() << "Не удалось отключить архив продаж за" << year;
+        return false;
+    }
+
+    archiveYears.removeAll(year);
+    return true;
+}
+
+bool Database::attachArchiveYears(const QList<int> &years)
+{
+    if (years.size() > MAX_ATTACHED_ARCHIVES)
+    {
+        lastSqlError = QSqlError(QString("Период затрагивает %1 архивов продаж, одновременно можно подключить не больше %2")
+                                     .arg(years.size()).arg(MAX_ATTACHED_ARCHIVES),
+                                 QString(), QSqlError::ConnectionError);
+        qDebug() << lastSqlError.text();
+        return false;
+    }
+
+    int missing = 0;
+    for (int year : years)
+    {
+        if (!archiveYears.contains(year))
+        {
+            missing++;
+        }
+    }
+
+    // Места не хватает: отключаем архивы, которые этому запросу не нужны
+    const QList<int> attached = archiveYears;
+    for (int year : attached)
+    {
+        if (archiveYears.size() + missing <= MAX_ATTACHED_ARCHIVES)
+        {
+            break;
+        }
+        if (!years.contains(year) && !detachArchive(year))
+        {
+            return false;
+        }
+    }
+
+    for (int year : years)
+    {
+        if (!attachArchive(year))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QList<int> Database::archiveYearsBetween(int firstYear, int lastYear) const
+{
+    QFileInfo info(db.databaseName());
+    QString prefix = info.completeBaseName() + "_archive_";
+
+    const QStringList files = info.absoluteDir().entryList(
+        QStringList() << prefix + "????.db", QDir::Files, QDir::Name);
+
+    QList<int> years;
+    for (const QString &file : files)
+    {
+        bool ok = false;
+        int year = file.mid(prefix.size(), 4).toInt(&ok);
+        if (ok && year >= firstYear && year <= lastYear)
+        {
+            years.append(year);
+        }
+    }
+
+    return years;
+}
+
+QString Database::findSaleSchema(int saleId)
+{
+    QSqlQuery query = prepareQuery("SELECT 1 FROM main.sales WHERE id = :id");
+    query.bindValue(":id", saleId);
+
+    if (executeQuery(query, "") && query.next())
+    {
+        return "main";
+    }
+
+    // Архивы перебираются от новых к старым и подключаются по одному,
+    // так что находится и архив, созданный другим соединением
+    const QList<int> years = archiveYearsBetween(0, 9999);
+    for (int i = years.size() - 1; i >= 0; i--)
+    {
+        if (!attachArchiveYears(QList<int>() << years[i]))
+        {
+            return QString();
+        }
+
+        QString schema = QString("archive_%1").arg(years[i]);
+        query = prepareQuery(QString("SELECT 1 FROM %1.sales WHERE id = :id").arg(schema));
+        query.bindValue(":id", saleId);
+
+        if (executeQuery(query, "") && query.next())
+        {
+            return schema;
+        }
+    }
+
+    return QString();
+}
+
+QString Database::saleLinesSource(int firstYear, int lastYear) const
+{
+    static const QString select =
+        "SELECT sa.sale_date, si.product_id, si.quantity, si.total_price "
+        "FROM %1.sale_items si JOIN %1.sales sa ON si.sale_id = sa.id";
+
+    QStringList parts;
+    parts << select.arg("main");
+
+    for (int year : archiveYears)
+    {
+        if (year >= firstYear && year <= lastYear)
+        {
+            parts << select.arg(QString("archive_%1").arg(year));
+        }
+    }
+
+    return "(" + parts.join(" UNION ALL ") + ")";
+}
+
+QList<int> Database::getArchiveYears() const
+{
+    return archiveYearsBetween(0, 9999);
+}
+
+bool Database::openSnapshotQuery(SnapshotTable table, QSqlQuery &query)
+{
+    QString select;
+
+    switch (table)
+    {
+    case SnapshotProducts:
+        select = "SELECT id, article, name, purchase_price, retail_price FROM %1.products";
+        break;
+    case SnapshotSales:
+        select = "SELECT id, receipt_number, sale_date, cashier_id, customer_id, "
+                 "total_amount, discount_amount, final_amount FROM %1.sales";
+        break;
+    case SnapshotSaleItems:
+        select = "SELECT id, sale_id, product_id, quantity, retail_price, total_price FROM %1.sale_items";
+        break;
+    }
+
+    // Продажи берутся из архивов по возрастанию года, затем из основной базы,
+    // внутри каждой части по id: строки в снимке идут почти по возрастанию даты
+    QStringList parts;
+    if (table != SnapshotProducts)
+    {
+        const QList<int> years = archiveYearsBetween(0, 9999);
+        if (!attachArchiveYears(years))
+        {
+            return false;
+        }
+        for (int year : years)
+        {
+            parts << "SELECT * FROM (" + select.arg(QString("archive_%1").arg(year)) + " ORDER BY id)";
+        }
+    }
+    parts << "SELECT * FROM (" + select.arg("main") + " ORDER BY id)";
+
+    query = QSqlQuery(db);
+    query.setForwardOnly(true);
+
+    return executeQuery(query, parts.join(" UNION ALL "));
+}
+
+bool Database::openReceiptQuery(const QDate &startDate, const QDate &endDate, int cashierId, QSqlQuery &query)
+{
+    // Одна выборка на все чеки периода: строки одного чека идут подряд,
+    // продажа без позиций дает одну строку с NULL в полях позиции.
+    // Границы подставляются в текст, потому что повторяются в каждой части UNION
+    static const QString select =
+        "SELECT * FROM ("
+        "SELECT sa.id, sa.receipt_number, sa.sale_date, "
+        "sa.cashier_id, cashier.login, sa.customer_id, customer.login, "
+        "sa.total_amount, sa.discount_amount, sa.final_amount, sa.created_at, "
+        "si.id, si.product_id, p.name, si.quantity, si.retail_price, si.total_price "
+        "FROM %1.sales sa "
+        "LEFT JOIN %1.sale_items si ON si.sale_id = sa.id "
+        "LEFT JOIN main.products p ON si.product_id = p.id "
+        "LEFT JOIN main.users cashier ON sa.cashier_id = cashier.id "
+        "LEFT JOIN main.users customer ON sa.customer_id = customer.id "
+        "WHERE sa.sale_date >= '%2' AND sa.sale_date < '%3'%4 "
+        "ORDER BY sa.id, si.id)";
+
+    QString start = startDate.toString("yyyy-MM-dd");
+    QString end = endDate.addDays(1).toString("yyyy-MM-dd");
+    QString cashierFilter = cashierId > 0 ? QString(" AND sa.cashier_id = %1").arg(cashierId) : QString();
+
+    const QList<int> years = archiveYearsBetween(startDate.year(), endDate.year());
+    if (!attachArchiveYears(years))
+    {
+        return false;
+    }
+
+    QStringList parts;
+    for (int year : years)
+    {
+        parts << select.arg(QString("archive_%1").arg(year), start, end, cashierFilter);
+    }
+    parts << select.arg("main", start, end, cashierFilter);
+
+    query = QSqlQuery(db);
+    query.setForwardOnly(true);
+
+    return executeQuery(query, parts.join(" UNION ALL "));
+}
+
+int Database::archiveSales(const QDate &before)
+{
+    QString cutoff = before.toString("yyyy-MM-dd");
+
+    QSqlQuery query = prepareQuery(
+        "SELECT DISTINCT substr(sale_date, 1, 4) FROM sales WHERE sale_date < :cutoff");
+    query.bindValue(":cutoff", cutoff);
+
+    if (!executeQuery(query, ""))
+    {
+        return -1;
+    }
+
+    QList<int> years;
+    while (query.next())
     {
-        db.rollback();
-        qDebug() << "Ошибка при добавлении поставки:" << e.what();
-        return false;
+        years.append(query.value(0).toInt());
     }
-    catch (...)
+    query.finish();
+
+    // ATTACH невозможен внутри транзакции, поэтому архивы подключаются заранее
+    if (!attachArchiveYears(years))
     {
-        db.rollback();
-        qDebug() << "Неизвестная ошибка при добавлении поставки";
-        return false;
+        return -1;
     }
-}
 
-bool Database::deleteSupply(int supplyId)
-{
-    QSqlQuery query = prepareQuery("DELETE FROM supplies WHERE id = :id");
-    query.bindValue(":id", supplyId);
+    int archived = 0;
 
-    return executeQuery(query, "");
+    bool success = runInTransaction([&]() {
+        archived = 0;
+
+        for (int year : years)
+        {
+            QString schema = QString("archive_%1").arg(year);
+            QString yearStart = QString("%1-01-01").arg(year);
+            QString periodEnd = qMin(cutoff, QString("%1-01-01").arg(year + 1));
+
+            for (const char *statement : archiveSchema)
+            {
+                QSqlQuery ddl(db);
+                if (!executeQuery(ddl, QString::fromUtf8(statement).arg(schema)))
+                {
+                    return false;
+                }
+            }
+
+            const QString period = "sale_date >= :year_start AND sale_date < :period_end";
+            const QString salesOfPeriod = "sale_id IN (SELECT id FROM main.sales WHERE " + period + ")";
+
+            QStringList statements;
+            statements
+                << QString("INSERT INTO %1.sales (id, receipt_number, sale_date, cashier_id, customer_id, "
+                           "total_amount, discount_amount, final_amount, created_at) "
+                           "SELECT id, receipt_number, sale_date, cashier_id, customer_id, "
+                           "total_amount, discount_amount, final_amount, created_at "
+                           "FROM main.sales WHERE %2").arg(schema, period)
+                << QString("INSERT INTO %1.sale_items (id, sale_id, product_id, quantity, retail_price, total_price) "
+                           "SELECT id, sale_id, product_id, quantity, retail_price, total_price "
+                           "FROM main.sale_items WHERE %2").arg(schema, salesOfPeriod)
+                << QString("INSERT INTO main.archived_sale_totals (product_id, quantity) "
+                           "SELECT product_id, SUM(quantity) FROM main.sale_items WHERE %1 "
+                           "GROUP BY product_id "
+                           "ON CONFLICT(product_id) DO UPDATE SET quantity = quantity + excluded.quantity")
+                       .arg(salesOfPeriod)
+                << QString("DELETE FROM main.sale_items WHERE %1").arg(salesOfPeriod)
+                << QString("DELETE FROM main.sales WHERE %1").arg(period);
+
+            for (const QString &statement : statements)
+            {
+                QSqlQuery move = prepareQuery(statement);
+                move.bindValue(":year_start", yearStart);
+                move.bindValue(":period_end", periodEnd);
+
+                if (!executeQuery(move, ""))
+                {
+                    return false;
+                }
+
+                if (statement.startsWith("DELETE FROM main.sales"))
+                {
+                    archived += move.numRowsAffected();
+                }
+            }
+        }
+
+        return true;
+    });
+
+    return success ? archived : -1;
 }
 
-Sale Database::getSaleDetails(int saleId)
+QList<PromotionRule> Database::getActivePromotions()
 {
-    Sale sale;
-    sale.id = -1;
+    QList<PromotionRule> rules;
 
     QSqlQuery query = prepareQuery(
-        "SELECT sa.id, sa.receipt_number, sa.sale_date, "
-        "sa.cashier_id, cashier.login, sa.customer_id, customer.login, "
-        "sa.total_amount, sa.discount_amount, sa.final_amount, sa.created_at "
-        "FROM sales sa "
-        "LEFT JOIN users cashier ON sa.cashier_id = cashier.id "
-        "LEFT JOIN users customer ON sa.customer_id = customer.id "
-        "WHERE sa.id = :id");
-
-    query.bindValue(":id", saleId);
+        "SELECT id, name, kind, percent, min_quantity, category_id, product_id, bundle_product_id, "
+        "valid_from, valid_to, hour_from, hour_to "
+        "FROM promotions WHERE active = 1 ORDER BY id");
 
     if (!executeQuery(query, ""))
     {
-        return sale;
+        return rules;
     }
 
-    if (query.next())
+    while (query.next())
     {
-        sale.id = query.value(0).toInt();
-        sale.receiptNumber = query.value(1).toString();
-        sale.saleDate = query.value(2).toDateTime();
-        sale.cashierId = query.value(3).toInt();
-        sale.cashierName = query.value(4).toString();
-        sale.customerId = query.value(5).toInt();
-        sale.customerName = query.value(6).toString();
-        sale.totalAmount = query.value(7).toDouble();
-        sale.discountAmount = query.value(8).toDouble();
-        sale.finalAmount = query.value(9).toDouble();
-        sale.createdAt = query.value(10).toDateTime();
+        QString kind = query.value(2).toString();
+
+        PromotionRule rule;
+        rule.id = query.value(0).toInt();
+        rule.name = query.value(1).toString();
+        rule.kind = kind == "category" ? PromotionRule::CategoryDiscount
+                  : kind == "bundle" ? PromotionRule::Bundle
+                  : PromotionRule::QuantityTier;
+        rule.percent = query.value(3).toDouble();
+        rule.minQuantity = query.value(4).toInt();
+        rule.categoryId = query.value(5).toInt();
+        rule.productId = query.value(6).toInt();
+        rule.bundleProductId = query.value(7).toInt();
+        rule.validFrom = query.value(8).toDateTime();
+        rule.validTo = query.value(9).toDateTime();
+        rule.hourFrom = query.isNull(10) ? -1 : query.value(10).toInt();
+        rule.hourTo = query.isNull(11) ? -1 : query.value(11).toInt();
+
+        rules.append(rule);
     }
 
-    return sale;
+    return rules;
 }
 
-QList<SaleItem> Database::getSaleItems(int saleId)
+QList<PriceListEntry> Database::getPriceListEntries(const QDateTime &after)
 {
-    QList<SaleItem> items;
+    QList<PriceListEntry> entries;
 
+    // Закончившиеся прайс-листы не нужны: индекс строится от текущего момента
     QSqlQuery query = prepareQuery(
-        "SELECT si.id, si.sale_id, si.product_id, p.name, "
-        "si.quantity, si.retail_price, si.total_price "
-        "FROM sale_items si "
-        "JOIN products p ON si.product_id = p.id "
-        "WHERE si.sale_id = :sale_id");
-
-    query.bindValue(":sale_id", saleId);
+        "SELECT pl.id, pli.product_id, pli.retail_price, pl.valid_from, pl.valid_to "
+        "FROM price_lists pl "
+        "JOIN price_list_items pli ON pli.price_list_id = pl.id "
+        "WHERE pl.valid_to IS NULL OR pl.valid_to > :after "
+        "ORDER BY pli.product_id, pl.valid_from, pl.id");
+    query.bindValue(":after", after);
 
     if (!executeQuery(query, ""))
     {
-        return items;
+        return entries;
     }
 
     while (query.next())
     {
-        SaleItem item;
-        item.id = query.value(0).toInt();
-        item.saleId = query.value(1).toInt();
-        item.productId = query.value(2).toInt();
-        item.productName = query.value(3).toString();
-        item.quantity = query.value(4).toInt();
-        item.retailPrice = query.value(5).toDouble();
-        item.totalPrice = query.value(6).toDouble();
-
-        items.append(item);
+        PriceListEntry entry;
+        entry.priceListId = query.value(0).toInt();
+        entry.productId = query.value(1).toInt();
+        entry.retailPrice = query.value(2).toDouble();
+        entry.validFrom = query.value(3).toDateTime();
+        entry.validTo = query.value(4).toDateTime();
+
+        entries.append(entry);
     }
 
-    return items;
+    return entries;
 }
 
-ProfitReport Database::generateProfitReport(const QDate &startDate, const QDate &endDate)
+int Database::addPriceList(const QString &name, const QDateTime &validFrom, const QDateTime &validTo,
+                           const QList<QPair<int, double>> &prices)
 {
-    ProfitReport report;
-    report.startDate = startDate;
-    report.endDate = endDate;
-
-    QSqlQuery query = prepareQuery(
-        "SELECT "
-        "SUM(si.total_price) as revenue, "
-        "SUM(si.quantity * p.purchase_price) as cost "
-        "FROM sale_items si "
-        "JOIN products p ON si.product_id = p.id "
-        "JOIN sales sa ON si.sale_id = sa.id "
-        "WHERE DATE(sa.sale_date) BETWEEN :start_date AND :end_date");
+    int priceListId = -1;
 
-    query.bindValue(":start_date", startDate.toString("yyyy-MM-dd"));
-    query.bindValue(":end_date", endDate.toString("yyyy-MM-dd"));
+    bool success = runInTransaction([&]() {
+        QSqlQuery query = prepareQuery(
+            "INSERT INTO price_lists (name, valid_from, valid_to) VALUES (:name, :valid_from, :valid_to)");
+        query.bindValue(":name", name);
+        query.bindValue(":valid_from", validFrom);
+        query.bindValue(":valid_to", validTo.isValid() ? QVariant(validTo) : QVariant());
 
-    if (executeQuery(query, "") && query.next())
-    {
-        report.totalRevenue = query.value(0).toDouble();
-        report.totalCost = query.value(1).toDouble();
-        report.totalProfit = report.totalRevenue - report.totalCost;
-    }
+        if (!executeQuery(query, ""))
+        {
+            return false;
+        }
 
-    query = prepareQuery(
-        "SELECT p.name, SUM(si.quantity) as total_quantity "
-        "FROM sale_items si "
-        "JOIN products p ON si.product_id = p.id "
-        "JOIN sales sa ON si.sale_id = sa.id "
-        "WHERE DATE(sa.sale_date) BETWEEN :start_date AND :end_date "
-        "GROUP BY p.id, p.name "
-        "ORDER BY total_quantity DESC "
-        "LIMIT 10");
+        priceListId = query.lastInsertId().toInt();
 
-    query.bindValue(":start_date", startDate.toString("yyyy-MM-dd"));
-    query.bindValue(":end_date", endDate.toString("yyyy-MM-dd"));
+        QSqlQuery itemQuery = prepareQuery(
+            "INSERT INTO price_list_items (price_list_id, product_id, retail_price) "
+            "VALUES (:price_list_id, :product_id, :retail_price)");
 
-    if (executeQuery(query, ""))
-    {
-        while (query.next())
+        for (const QPair<int, double> &price : prices)
         {
-            report.popularProducts.append(
-                qMakePair(query.value(0).toString(), query.value(1).toInt()));
+            itemQuery.bindValue(":price_list_id", priceListId);
+            itemQuery.bindValue(":product_id", price.first);
+            itemQuery.bindValue(":retail_price", Money::fromDouble(price.second).toDouble());
+
+            if (!executeQuery(itemQuery, ""))
+            {
+                return false;
+            }
         }
+
+        return true;
+    });
+
+    if (!success)
+    {
+        return -1;
     }
 
-    return report;
+    PriceIndex::instance().invalidate();
+    return priceListId;
 }
 
 QList<Product> Database::getProductsForCashier()
@@ -490,11 +2212,11 @@ QList<Product> Database::getProductsForCashier()
     QList<Product> products;
 
     QSqlQuery query = prepareQuery(
-        "SELECT p.id, p.article, p.name, p.category_id, pc.name, "
-        "p.purchase_price, p.retail_price, p.stock, p.created_at, p.updated_at "
+        "SELECT p.id, p.article, p.name, p.category_id, "
+        "p.purchase_price, p.retail_price, ps.stock, p.created_at, p.updated_at, p.version "
         "FROM products p "
-        "LEFT JOIN product_categories pc ON p.category_id = pc.id "
-        "WHERE p.stock > 0 "
+        "JOIN product_stock ps ON ps.product_id = p.id "
+        "WHERE ps.stock > 0 "
         "ORDER BY p.name");
 
     if (!executeQuery(query, ""))
@@ -509,55 +2231,53 @@ QList<Product> Database::getProductsForCashier()
         product.article = query.value(1).toString();
         product.name = query.value(2).toString();
         product.categoryId = query.value(3).toInt();
-        product.categoryName = query.value(4).toString();
-        product.purchasePrice = query.value(5).toDouble();
-        product.retailPrice = query.value(6).toDouble();
-        product.stock = query.value(7).toInt();
-        product.createdAt = query.value(8).toDateTime();
-        product.updatedAt = query.value(9).toDateTime();
+        product.purchasePrice = query.value(4).toDouble();
+        product.retailPrice = query.value(5).toDouble();
+        product.stock = query.value(6).toInt();
+        product.createdAt = query.value(7).toDateTime();
+        product.updatedAt = query.value(8).toDateTime();
+        product.version = query.value(9).toInt();
 
         products.append(product);
     }
 
+    PriceIndex::instance().apply(*this, products);
     return products;
 }
 
 int Database::createSale(Sale &sale, const QList<SaleItem> &items)
 {
-    try
-    {
-        db.transaction();
+    int saleId = -1;
 
+    bool success = runInTransaction([&]() {
         foreach (const SaleItem &item, items)
         {
             QSqlQuery checkQuery = prepareQuery(
-                "SELECT stock FROM products WHERE id = :product_id");
+                "SELECT stock FROM product_stock WHERE product_id = :product_id");
             checkQuery.bindValue(":product_id", item.productId);
 
             if (!executeQuery(checkQuery, "") || !checkQuery.next())
             {
-                db.rollback();
                 qDebug() << "Товар не найден:" << item.productId;
-                return -1;
+                return false;
             }
 
             int availableStock = checkQuery.value(0).toInt();
             if (availableStock < item.quantity)
             {
-                db.rollback();
                 qDebug() << QString("Недостаточно товара на складе. Товар ID: %1, Доступно: %2, Заказано: %3")
                                 .arg(item.productId)
                                 .arg(availableStock)
                                 .arg(item.quantity);
-                return -1;
+                return false;
             }
         }
 
         QSqlQuery query = prepareQuery(
             "INSERT INTO sales (receipt_number, sale_date, cashier_id, customer_id, "
-            "total_amount, discount_amount) "
+            "total_amount, discount_amount, final_amount) "
             "VALUES (:receipt_number, :sale_date, :cashier_id, :customer_id, "
-            ":total_amount, :discount_amount)");
+            ":total_amount, :discount_amount, :final_amount)");
 
         sale.receiptNumber = generateReceiptNumber();
         sale.saleDate = QDateTime::currentDateTime();
@@ -568,15 +2288,15 @@ int Database::createSale(Sale &sale, const QList<SaleItem> &items)
         query.bindValue(":customer_id", sale.customerId > 0 ? sale.customerId : QVariant());
         query.bindValue(":total_amount", sale.totalAmount);
         query.bindValue(":discount_amount", sale.discountAmount);
+        query.bindValue(":final_amount", sale.finalAmount);
 
         if (!executeQuery(query, ""))
         {
-            db.rollback();
             qDebug() << "Ошибка при вставке продажи:" << query.lastError().text();
-            return -1;
+            return false;
         }
 
-        int saleId = query.lastInsertId().toInt();
+        saleId = query.lastInsertId().toInt();
 
         foreach (const SaleItem &item, items)
         {
@@ -592,34 +2312,29 @@ int Database::createSale(Sale &sale, const QList<SaleItem> &items)
 
             if (!executeQuery(query, ""))
             {
-                db.rollback();
                 qDebug() << "Ошибка при вставке товара продажи:" << query.lastError().text();
-                return -1;
+                return false;
             }
         }
 
-        db.commit();
-        sale.id = saleId;
-
-        Sale finalSale = getSaleDetails(saleId);
-        sale.finalAmount = finalSale.finalAmount;
-        sale.cashierName = finalSale.cashierName;
-        sale.customerName = finalSale.customerName;
+        return true;
+    });
 
-        return saleId;
-    }
-    catch (const std::exception &e)
+    if (!success)
     {
-        db.rollback();
-        qDebug() << "Ошибка при создании продажи:" << e.what();
         return -1;
     }
-    catch (...)
+
+    sale.id = saleId;
+
+    // Суммы и имена после триггеров: вызывающий строит по ним чек без повторного чтения
+    Sale finalSale = getSaleDetails(saleId);
+    if (finalSale.id != -1)
     {
-        db.rollback();
-        qDebug() << "Неизвестная ошибка при создании продажи";
-        return -1;
+        sale = finalSale;
     }
+
+    return saleId;
 }
 
 QList<Sale> Database::getSalesByCashier(int cashierId)
@@ -671,10 +2386,7 @@ QList<Product> Database::getProductsForClient()
 
 bool Database::addToCart(int userId, int productId, int quantity)
 {
-    try
-    {
-        db.transaction();
-
+    return runInTransaction([&]() {
         QSqlQuery query = prepareQuery(
             "INSERT INTO cart_items (user_id, product_id, quantity) "
             "VALUES (:user_id, :product_id, :quantity) "
@@ -685,31 +2397,21 @@ bool Database::addToCart(int userId, int productId, int quantity)
         query.bindValue(":product_id", productId);
         query.bindValue(":quantity", quantity);
 
-        if (!executeQuery(query, ""))
-        {
-            db.rollback();
-            return false;
-        }
-
-        db.commit();
-        return true;
-    }
-    catch (...)
-    {
-        db.rollback();
-        return false;
-    }
+        return executeQuery(query, "");
+    });
 }
 
 bool Database::removeFromCart(int userId, int productId)
 {
-    QSqlQuery query = prepareQuery(
-        "DELETE FROM cart_items WHERE user_id = :user_id AND product_id = :product_id");
+    return runInTransaction([&]() {
+        QSqlQuery query = prepareQuery(
+            "DELETE FROM cart_items WHERE user_id = :user_id AND product_id = :product_id");
 
-    query.bindValue(":user_id", userId);
-    query.bindValue(":product_id", productId);
+        query.bindValue(":user_id", userId);
+        query.bindValue(":product_id", productId);
 
-    return executeQuery(query, "");
+        return executeQuery(query, "");
+    });
 }
 
 bool Database::updateCartItemQuantity(int userId, int productId, int quantity)
@@ -717,15 +2419,17 @@ bool Database::updateCartItemQuantity(int userId, int productId, int quantity)
     if (quantity <= 0)
         return removeFromCart(userId, productId);
 
-    QSqlQuery query = prepareQuery(
-        "UPDATE cart_items SET quantity = :quantity "
-        "WHERE user_id = :user_id AND product_id = :product_id");
+    return runInTransaction([&]() {
+        QSqlQuery query = prepareQuery(
+            "UPDATE cart_items SET quantity = :quantity "
+            "WHERE user_id = :user_id AND product_id = :product_id");
 
-    query.bindValue(":user_id", userId);
-    query.bindValue(":product_id", productId);
-    query.bindValue(":quantity", quantity);
+        query.bindValue(":user_id", userId);
+        query.bindValue(":product_id", productId);
+        query.bindValue(":quantity", quantity);
 
-    return executeQuery(query, "");
+        return executeQuery(query, "");
+    });
 }
 
 QList<CartItem> Database::getCartItems(int userId)
@@ -733,7 +2437,8 @@ QList<CartItem> Database::getCartItems(int userId)
     QList<CartItem> cartItems;
 
     QSqlQuery query = prepareQuery(
-        "SELECT ci.id, ci.user_id, ci.product_id, p.name, p.retail_price, ci.quantity, ci.added_at "
+        "SELECT ci.id, ci.user_id, ci.product_id, p.name, p.retail_price, ci.quantity, ci.added_at, "
+        "p.category_id "
         "FROM cart_items ci "
         "JOIN products p ON ci.product_id = p.id "
         "WHERE ci.user_id = :user_id "
@@ -756,6 +2461,8 @@ QList<CartItem> Database::getCartItems(int userId)
         item.retailPrice = query.value(4).toDouble();
         item.quantity = query.value(5).toInt();
         item.addedAt = query.value(6).toDateTime();
+        item.categoryId = query.value(7).toInt();
+        item.retailPrice = PriceIndex::instance().price(*this, item.productId, item.retailPrice).toDouble();
 
         cartItems.append(item);
     }
@@ -765,63 +2472,73 @@ QList<CartItem> Database::getCartItems(int userId)
 
 bool Database::clearCart(int userId)
 {
-    QSqlQuery query = prepareQuery(
-        "DELETE FROM cart_items WHERE user_id = :user_id");
+    return runInTransaction([&]() {
+        QSqlQuery query = prepareQuery(
+            "DELETE FROM cart_items WHERE user_id = :user_id");
 
-    query.bindValue(":user_id", userId);
+        query.bindValue(":user_id", userId);
 
-    return executeQuery(query, "");
+        return executeQuery(query, "");
+    });
 }
 
 bool Database::createSaleForClient(Sale &sale)
 {
-    try
-    {
-        db.transaction();
+    int saleId = -1;
+    double manualDiscount = sale.discountAmount;
 
+    bool success = runInTransaction([&]() {
         QList<CartItem> cartItems = getCartItems(sale.customerId);
         if (cartItems.isEmpty())
         {
-            db.rollback();
             return false;
         }
 
-        double totalAmount = 0;
         QList<SaleItem> saleItems;
+        QVector<BasketLine> basket;
+        basket.reserve(cartItems.size());
 
         for (const CartItem &cartItem : cartItems)
         {
+            Money price = Money::fromDouble(cartItem.retailPrice);
+
             SaleItem item;
             item.productId = cartItem.productId;
             item.quantity = cartItem.quantity;
-            item.retailPrice = cartItem.retailPrice;
-            item.totalPrice = cartItem.quantity * cartItem.retailPrice;
+            item.retailPrice = price.toDouble();
+            item.totalPrice = (price * cartItem.quantity).toDouble();
 
-            totalAmount += item.totalPrice;
+            basket.append({cartItem.productId, cartItem.categoryId, price, cartItem.quantity});
             saleItems.append(item);
         }
 
-        sale.receiptNumber = generateReceiptNumber();
+        // Та же цена, что клиент видел в корзине: правила на момент оформления
         sale.saleDate = QDateTime::currentDateTime();
-        sale.totalAmount = totalAmount;
+        PromotionResult totals = PromotionEngine::load(*this, sale.saleDate).evaluate(basket);
+        totals.addManualDiscount(manualDiscount);
+
+        sale.receiptNumber = generateReceiptNumber();
+        sale.totalAmount = totals.subtotal.toDouble();
+        sale.discountAmount = totals.percent();
+        sale.finalAmount = totals.total.toDouble();
 
         QSqlQuery query = prepareQuery(
-            "INSERT INTO sales (receipt_number, sale_date, customer_id, total_amount, discount_amount) "
-            "VALUES (:receipt_number, :sale_date, :customer_id, :total_amount, :discount_amount)");
+            "INSERT INTO sales (receipt_number, sale_date, customer_id, total_amount, discount_amount, final_amount) "
+            "VALUES (:receipt_number, :sale_date, :customer_id, :total_amount, :discount_amount, :final_amount)");
 
         query.bindValue(":receipt_number", sale.receiptNumber);
         query.bindValue(":sale_date", sale.saleDate);
         query.bindValue(":customer_id", sale.customerId);
         query.bindValue(":total_amount", sale.totalAmount);
         query.bindValue(":discount_amount", sale.discountAmount);
+        query.bindValue(":final_amount", sale.finalAmount);
 
         if (!executeQuery(query, ""))
         {
-            db.rollback();
             return false;
         }
 
-        int saleId = query.lastInsertId().toInt();
+        saleId = query.lastInsertId().toInt();
 
         for (const SaleItem &item : saleItems)
         {
@@ -837,7 +2554,6 @@ bool Database::createSaleForClient(Sale &sale)
 
             if (!executeQuery(query, ""))
             {
-                db.rollback();
                 return false;
             }
         }
@@ -846,21 +2562,15 @@ bool Database::createSaleForClient(Sale &sale)
         query = prepareQuery("DELETE FROM cart_items WHERE user_id = :user_id");
         query.bindValue(":user_id", sale.customerId);
 
-        if (!executeQuery(query, ""))
-        {
-            db.rollback();
-            return false;
-        }
+        return executeQuery(query, "");
+    });
 
-        db.commit();
-        sale.id = saleId;
-        return true;
-    }
-    catch (...)
+    if (success)
     {
-        db.rollback();
-        return false;
+        sale.id = saleId;
     }
+
+    return success;
 }
 
 User Database::getUserById(int userId)
@@ -889,16 +2599,43 @@ User Database::getUserById(int userId)
     return user;
 }
 
+QList<User> Database::getUsersByRole(const QString &role)
+{
+    QList<User> users;
+
+    QSqlQuery query = prepareQuery(
+        "SELECT id, login, role, created_at FROM users WHERE role = :role ORDER BY login");
+    query.bindValue(":role", role);
+
+    if (!executeQuery(query, ""))
+    {
+        return users;
+    }
+
+    while (query.next())
+    {
+        User user;
+        user.id = query.value(0).toInt();
+        user.login = query.value(1).toString();
+        user.role = query.value(2).toString();
+        user.createdAt = query.value(3).toDateTime();
+
+        users.append(user);
+    }
+
+    return users;
+}
+
 Product Database::getProductById(int productId)
 {
     Product product;
     product.id = -1;
 
     QSqlQuery query = prepareQuery(
-        "SELECT p.id, p.article, p.name, p.category_id, pc.name, "
-        "p.purchase_price, p.retail_price, p.stock, p.created_at, p.updated_at "
+        "SELECT p.id, p.article, p.name, p.category_id, "
+        "p.purchase_price, p.retail_price, ps.stock, p.created_at, p.updated_at, p.version "
         "FROM products p "
-        "LEFT JOIN product_categories pc ON p.category_id = pc.id "
+        "JOIN product_stock ps ON ps.product_id = p.id "
         "WHERE p.id = :id");
 
     query.bindValue(":id", productId);
@@ -914,17 +2651,101 @@ Product Database::getProductById(int productId)
         product.article = query.value(1).toString();
         product.name = query.value(2).toString();
         product.categoryId = query.value(3).toInt();
-        product.categoryName = query.value(4).toString();
-        product.purchasePrice = query.value(5).toDouble();
-        product.retailPrice = query.value(6).toDouble();
-        product.stock = query.value(7).toInt();
-        product.createdAt = query.value(8).toDateTime();
-        product.updatedAt = query.value(9).toDateTime();
+        product.purchasePrice = query.value(4).toDouble();
+        product.retailPrice = query.value(5).toDouble();
+        product.stock = query.value(6).toInt();
+        product.createdAt = query.value(7).toDateTime();
+        product.updatedAt = query.value(8).toDateTime();
+        product.version = query.value(9).toInt();
+    }
+
+    return product;
+}
+
+Product Database::getProductByArticle(const QString &article)
+{
+    Product product;
+    product.id = -1;
+
+    QSqlQuery query = prepareQuery(
+        "SELECT p.id, p.article, p.name, p.category_id, "
+        "p.purchase_price, p.retail_price, ps.stock, p.created_at, p.updated_at, p.version "
+        "FROM products p "
+        "JOIN product_stock ps ON ps.product_id = p.id "
+        "WHERE p.article = :article");
+
+    query.bindValue(":article", article);
+
+    if (!executeQuery(query, ""))
+    {
+        return product;
+    }
+
+    if (query.next())
+    {
+        product.id = query.value(0).toInt();
+        product.article = query.value(1).toString();
+        product.name = query.value(2).toString();
+        product.categoryId = query.value(3).toInt();
+        product.purchasePrice = query.value(4).toDouble();
+        product.retailPrice = query.value(5).toDouble();
+        product.stock = query.value(6).toInt();
+        product.createdAt = query.value(7).toDateTime();
+        product.updatedAt = query.value(8).toDateTime();
+        product.version = query.value(9).toInt();
     }
 
     return product;
 }
 
+QList<Product> Database::searchProducts(const QString &prefix, int offset, int limit)
+{
+    QList<Product> products;
+
+    QString escaped = prefix;
+    escaped.replace('\\', "\\\\").replace('%', "\\%").replace('_', "\\_");
+
+    // NOCASE сравнивает без учета регистра только латиницу, поэтому название
+    // ищется еще и с заглавной первой буквой: "мол" находит "Молоко"
+    QString capitalized = escaped.left(1).toUpper() + escaped.mid(1);
+
+    QSqlQuery query = prepareQuery(
+        "SELECT id, article, name, category_id, purchase_price, retail_price, version "
+        "FROM products "
+        "WHERE name LIKE :name ESCAPE '\\' OR name LIKE :capitalized ESCAPE '\\' "
+        "OR article LIKE :article ESCAPE '\\' "
+        "ORDER BY name COLLATE NOCASE, id "
+        "LIMIT :limit OFFSET :offset");
+
+    query.bindValue(":name", escaped + "%");
+    query.bindValue(":capitalized", capitalized + "%");
+    query.bindValue(":article", escaped + "%");
+    query.bindValue(":limit", limit);
+    query.bindValue(":offset", offset);
+
+    if (!executeQuery(query, ""))
+    {
+        return products;
+    }
+
+    while (query.next())
+    {
+        Product product;
+        product.id = query.value(0).toInt();
+        product.article = query.value(1).toString();
+        product.name = query.value(2).toString();
+        product.categoryId = query.value(3).toInt();
+        product.purchasePrice = query.value(4).toDouble();
+        product.retailPrice = query.value(5).toDouble();
+        product.stock = 0;
+        product.version = query.value(6).toInt();
+
+        products.append(product);
+    }
+
+    return products;
+}
+
 QString Database::generateReceiptNumber()
 {
     QString prefix = "CHK";
@@ -983,11 +2804,19 @@ ProductCategory Database::getCategoryById(int categoryId)
 
 bool Database::addCategory(const QString &name)
 {
-    QSqlQuery query = prepareQuery(
-        "INSERT INTO product_categories (name) VALUES (:name)");
-    query.bindValue(":name", name);
+    bool success = runInTransaction([&]() {
+        QSqlQuery query = prepareQuery(
+            "INSERT INTO product_categories (name) VALUES (:name)");
+        query.bindValue(":name", name);
 
-    return executeQuery(query, "");
+        return executeQuery(query, "");
+    });
+
+    if (success) {
+        CategoryCache::instance().invalidate();
+    }
+
+    return success;
 }
 
 QString Database::generateSupplyNumber()
@@ -1006,7 +2835,7 @@ bool Database::checkProductAvailability(int productId, int requestedQuantity)
     try
     {
         QSqlQuery query = prepareQuery(
-            "SELECT stock FROM products WHERE id = :product_id");
+            "SELECT stock FROM product_stock WHERE product_id = :product_id");
         query.bindValue(":product_id", productId);
 
         if (!executeQuery(query, ""))
@@ -11,6 +11,7 @@
 #include <QRandomGenerator>
 #include <QTextStream>
 #include <QFile>
+#include <functional>
 
 struct User {
     int id;
@@ -25,12 +26,13 @@ struct Product {
     QString article;
     QString name;
     int categoryId;
-    QString categoryName;
+    QString categoryName;   // запросы не заполняют, см. CategoryCache::resolve
     double purchasePrice;
     double retailPrice;
     int stock;
     QDateTime createdAt;
     QDateTime updatedAt;
+    int version;
 };
 
 struct Supply {
@@ -48,6 +50,14 @@ struct Supply {
     QDateTime createdAt;
 };
 
+struct SupplyDocument {
+    int id;
+    QString documentNumber;
+    QString supplierName;
+    QDateTime supplyDate;
+    QList<Supply> lines;
+};
+
 struct Sale {
     int id;
     QString receiptNumber;
@@ -77,6 +87,7 @@ struct CartItem {
     int userId;
     int productId;
     QString productName;
+    int categoryId;
     double retailPrice;
     int quantity;
     QDateTime addedAt;
@@ -91,17 +102,128 @@ struct ProfitReport {
     QList<QPair<QString, int>> popularProducts;
 };
 
+struct PromotionRule {
+    enum Kind {
+        QuantityTier,
+        CategoryDiscount,
+        Bundle
+    };
+
+    int id;
+    QString name;
+    Kind kind;
+    double percent;
+    int minQuantity;
+    int categoryId;
+    int productId;
+    int bundleProductId;
+    QDateTime validFrom;
+    QDateTime validTo;
+    int hourFrom;
+    int hourTo;
+};
+
+struct PriceListEntry {
+    int priceListId;
+    int productId;
+    double retailPrice;
+    QDateTime validFrom;
+    QDateTime validTo;
+};
+
+struct StockMovement {
+    qint64 id;
+    int productId;
+    int quantity;
+    QString reason;
+    int referenceId;
+    QDateTime createdAt;
+};
+
+struct TransactionStats {
+    qint64 transactions;
+    qint64 retries;
+    qint64 failures;
+};
+
+struct ImportRecord {
+    enum Kind {
+        ProductRecord,
+        SupplyRecord
+    };
+
+    Kind kind;
+    qint64 line;
+    QString article;
+    QString name;
+    QString categoryName;
+    double purchasePrice;
+    double retailPrice;
+    int stock;
+    QString supplyNumber;
+    QString supplierName;
+    int productId;
+    int quantity;
+    QDateTime supplyDate;
+};
+
+struct ImportRowError {
+    qint64 line;
+    QString message;
+};
+
+struct ImportBatchResult {
+    int productsInserted;
+    int productsUpdated;
+    int suppliesInserted;
+};
+
 struct ProductCategory {
     int id;
     QString name;
     QDateTime createdAt;
 };
 
+// Условия массовой операции над товарами, объединяются через AND
+struct ProductFilter {
+    int categoryId = -1;       // -1 - любая категория, 0 - без категории
+    QString text;              // подстрока названия или артикула
+    QList<int> productIds;     // выделенные товары, пусто - без ограничения
+};
+
 class Database : public QObject
 {
     Q_OBJECT
 
 public:
+    enum UpdateResult {
+        UpdateOk,
+        UpdateConflict,
+        UpdateFailed
+    };
+
+    enum ExportTable {
+        ExportProducts,
+        ExportSupplies,
+        ExportSales
+    };
+
+    enum PriceColumn {
+        RetailPrice,
+        PurchasePrice
+    };
+
+    enum PriceChange {
+        ChangePercent,
+        ChangeAmount
+    };
+
+    enum SnapshotTable {
+        SnapshotProducts,
+        SnapshotSales,
+        SnapshotSaleItems
+    };
+
     explicit Database(QObject *parent = nullptr);
     ~Database();
 
@@ -116,17 +238,44 @@ public:
     QList<ProductCategory> getAllCategories();
 
     bool addProduct(const Product &product);
-    bool updateProduct(const Product &product);
+    UpdateResult updateProduct(const Product &product, int stockDelta = 0);
     bool deleteProduct(int productId);
 
+    int countProducts(const ProductFilter &filter);
+    int bulkChangePrice(const ProductFilter &filter, PriceColumn column, PriceChange change, double value);
+    int bulkMoveCategory(const ProductFilter &filter, int categoryId);
+
+    QList<StockMovement> getStockMovements(int productId);
+    bool createStockSnapshots(int minTail = 1);
+    bool getProductIdRange(int &minId, int &maxId);
+    int reconcileStock(const QList<int> &productIds);
+    static QString stockCheckQueryText();
+
     bool addSupply(const Supply &supply, int userId);
+    bool addSupplyDocument(SupplyDocument &document, int userId);
     bool deleteSupply(int supplyId);
 
+    bool importBatch(const QList<ImportRecord> &records, int userId,
+                     ImportBatchResult &result, QList<ImportRowError> &errors);
+    static QString exportQueryText(ExportTable table);
+    static QString exportCountQueryText(ExportTable table);
+
     Sale getSaleDetails(int saleId);
     QList<SaleItem> getSaleItems(int saleId);
 
     ProfitReport generateProfitReport(const QDate &startDate, const QDate &endDate);
 
+    int archiveSales(const QDate &before);
+    QList<int> getArchiveYears() const;
+    bool openSnapshotQuery(SnapshotTable table, QSqlQuery &query);
+    bool openReceiptQuery(const QDate &startDate, const QDate &endDate, int cashierId, QSqlQuery &query);
+
+    QList<PromotionRule> getActivePromotions();
+
+    QList<PriceListEntry> getPriceListEntries(const QDateTime &after);
+    int addPriceList(const QString &name, const QDateTime &validFrom, const QDateTime &validTo,
+                     const QList<QPair<int, double>> &prices);
+
     QList<Product> getProductsForCashier();
     int createSale(Sale &sale, const QList<SaleItem> &items);
     QList<Sale> getSalesByCashier(int cashierId);
@@ -141,7 +290,10 @@ public:
     bool createSaleForClient(Sale &sale);
 
     User getUserById(int userId);
+    QList<User> getUsersByRole(const QString &role);
     Product getProductById(int productId);
+    Product getProductByArticle(const QString &article);
+    QList<Product> searchProducts(const QString &prefix, int offset, int limit);
     QString generateReceiptNumber();
 
     ProductCategory getCategoryById(int categoryId);
@@ -150,11 +302,34 @@ public:
 
     bool checkProductAvailability(int productId, int requestedQuantity);
 
+    QSqlError lastError() const;
+    static bool isBusyError(const QSqlError &error);
+
+    static TransactionStats transactionStats();
+    static void resetTransactionStats();
+
 private:
     QSqlDatabase db;
+    QString connectionName;
+    QSqlError lastSqlError;
+    QList<int> archiveYears;
 
     bool executeQuery(QSqlQuery &query, const QString &queryText);
     QSqlQuery prepareQuery(const QString &queryText);
+    bool runInTransaction(const std::function<bool()> &body);
+    bool migrateSchema();
+    bool addStockMovement(int productId, int quantity, const QString &reason,
+                          const QVariant &referenceId = QVariant());
+    static QString productFilterClause(const ProductFilter &filter);
+    static void bindProductFilter(QSqlQuery &query, const ProductFilter &filter);
+
+    QString archivePath(int year) const;
+    bool attachArchive(int year);
+    bool detachArchive(int year);
+    bool attachArchiveYears(const QList<int> &years);
+    QList<int> archiveYearsBetween(int firstYear, int lastYear) const;
+    QString findSaleSchema(int saleId);
+    QString saleLinesSource(int firstYear, int lastYear) const;
 };
 
 #endif // DATABASE_H
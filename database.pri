@@ -0,0 +1,20 @@
+# Слой базы данных вместе с тем, что нужно database.cpp.
+# Подключается приложением, бенчмарками и нагрузочным тестом.
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/catalogevents.cpp \
+    $$PWD/categorycache.cpp \
+    $$PWD/database.cpp \
+    $$PWD/money.cpp \
+    $$PWD/priceindex.cpp \
+    $$PWD/promotionengine.cpp
+
+HEADERS += \
+    $$PWD/catalogevents.h \
+    $$PWD/categorycache.h \
+    $$PWD/database.h \
+    $$PWD/money.h \
+    $$PWD/priceindex.h \
+    $$PWD/promotionengine.h
@@ -1,9 +1,53 @@
 #include "authwindow.h"
+#include "storeservice.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+
+static int runHeadless(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Магазин бытовых товаров - безоконный режим");
+    parser.addHelpOption();
+
+    QCommandLineOption headlessOption("headless", "Запуск без интерфейса с JSON API на локальном сокете.");
+    QCommandLineOption socketOption("socket", "Имя локального сокета.", "name", "householdsgoodsstore");
+    QCommandLineOption dbOption("db", "Файл базы данных.", "file", "shop.db");
+    QCommandLineOption threadsOption("threads", "Количество рабочих потоков (0 - по числу ядер).", "count", "0");
+
+    parser.addOptions({headlessOption, socketOption, dbOption, threadsOption});
+    parser.process(a);
+
+    QString dbPath = parser.value(dbOption);
+
+    Database db;
+    if (dbPath == "shop.db" && !db.initializeDatabase())
+    {
+        qCritical() << "Не удалось инициализировать базу данных";
+        return 1;
+    }
+
+    StoreService service(dbPath, parser.value(threadsOption).toInt());
+    if (!service.listen(parser.value(socketOption)))
+    {
+        return 1;
+    }
+
+    return a.exec();
+}
 
 int main(int argc, char *argv[])
 {
+    for (int i = 1; i < argc; i++)
+    {
+        if (qstrcmp(argv[i], "--headless") == 0)
+        {
+            return runHeadless(argc, argv);
+        }
+    }
+
     QApplication a(argc, argv);
     AuthWindow w;
     w.show();
@@ -0,0 +1,35 @@
+#include "money.h"
+
+QString Money::toString() const
+{
+    qint64 absolute = value < 0 ? -value : value;
+    return QString("%1%2.%3")
+        .arg(value < 0 ? "-" : "")
+        .arg(absolute / 100)
+        .arg(absolute % 100, 2, 10, QChar('0'));
+}
+
+Money Money::percent(double percent) const
+{
+    // Процент скидки задается с точностью до сотых: считаем в десятитысячных
+    qint64 basisPoints = qRound64(percent * 100.0);
+    qint64 product = value * basisPoints;
+    qint64 rounded = product >= 0 ? (product + 5000) / 10000 : -((-product + 5000) / 10000);
+    return Money(rounded);
+}
+
+Money Money::sum(const qint64 *amounts, int count)
+{
+    qint64 total = 0;
+    for (int i = 0; i < count; i++) {
+        total += amounts[i];
+    }
+    return Money(total);
+}
+
+void Money::lineTotals(const qint64 *prices, const qint32 *quantities, qint64 *totals, int count)
+{
+    for (int i = 0; i < count; i++) {
+        totals[i] = prices[i] * quantities[i];
+    }
+}
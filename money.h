@@ -0,0 +1,50 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <QString>
+#include <QtGlobal>
+
+// Денежная сумма в копейках. Вся арифметика с ценами и итогами идет
+// в целых числах, в double сумма переводится только на границе с базой
+// (колонки REAL хранят значения, округленные до копеек).
+class Money
+{
+public:
+    constexpr Money() : value(0) {}
+
+    static constexpr Money fromMinor(qint64 minor) { return Money(minor); }
+    static Money fromDouble(double amount) { return Money(qRound64(amount * 100.0)); }
+
+    constexpr qint64 minor() const { return value; }
+    double toDouble() const { return value / 100.0; }
+    QString toString() const;
+
+    // Доля в процентах, округление до копейки половина вверх
+    Money percent(double percent) const;
+    Money discounted(double percent) const { return *this - this->percent(percent); }
+
+    Money operator+(Money other) const { return Money(value + other.value); }
+    Money operator-(Money other) const { return Money(value - other.value); }
+    Money operator*(qint64 quantity) const { return Money(value * quantity); }
+    Money &operator+=(Money other) { value += other.value; return *this; }
+    Money &operator-=(Money other) { value -= other.value; return *this; }
+
+    bool operator==(Money other) const { return value == other.value; }
+    bool operator!=(Money other) const { return value != other.value; }
+    bool operator<(Money other) const { return value < other.value; }
+    bool operator>(Money other) const { return value > other.value; }
+    bool operator<=(Money other) const { return value <= other.value; }
+    bool operator>=(Money other) const { return value >= other.value; }
+
+    // Ядра для массивов строк чека. Простые циклы по непрерывным массивам
+    // без ветвлений, компилятор разворачивает их в векторные инструкции.
+    static Money sum(const qint64 *amounts, int count);
+    static void lineTotals(const qint64 *prices, const qint32 *quantities, qint64 *totals, int count);
+
+private:
+    explicit constexpr Money(qint64 minor) : value(minor) {}
+
+    qint64 value;
+};
+
+#endif // MONEY_H
@@ -0,0 +1,107 @@
+#include "priceindex.h"
+#include <QMutexLocker>
+
+// Прайс-листы могут добавить из другого процесса
+static const int RELOAD_INTERVAL_SECS = 300;
+
+PriceIndex &PriceIndex::instance()
+{
+    static PriceIndex priceIndex;
+    return priceIndex;
+}
+
+PriceIndex::PriceIndex()
+    : stale(true)
+{
+}
+
+Money PriceIndex::price(Database &db, int productId, double basePrice)
+{
+    QMutexLocker locker(&mutex);
+    ensureCurrent(db, QDateTime::currentDateTime());
+
+    auto it = current.constFind(productId);
+    return it != current.constEnd() ? *it : Money::fromDouble(basePrice);
+}
+
+void PriceIndex::apply(Database &db, QList<Product> &products)
+{
+    QMutexLocker locker(&mutex);
+    ensureCurrent(db, QDateTime::currentDateTime());
+
+    if (current.isEmpty()) {
+        return;
+    }
+
+    for (Product &product : products) {
+        auto it = current.constFind(product.id);
+        if (it != current.constEnd()) {
+            product.retailPrice = it->toDouble();
+        }
+    }
+}
+
+void PriceIndex::invalidate()
+{
+    QMutexLocker locker(&mutex);
+    stale = true;
+}
+
+void PriceIndex::ensureCurrent(Database &db, const QDateTime &now)
+{
+    if (stale || !loadedAt.isValid() || loadedAt.secsTo(now) >= RELOAD_INTERVAL_SECS || now < loadedAt) {
+        reload(db, now);
+    } else if (nextBoundary.isValid() && now >= nextBoundary) {
+        rebuild(now);
+    }
+}
+
+void PriceIndex::reload(Database &db, const QDateTime &now)
+{
+    intervals.clear();
+
+    // Записи приходят упорядоченными по товару и началу действия
+    const QList<PriceListEntry> entries = db.getPriceListEntries(now);
+    for (const PriceListEntry &entry : entries) {
+        intervals[entry.productId].append({entry.validFrom, entry.validTo, entry.priceListId,
+                                           Money::fromDouble(entry.retailPrice)});
+    }
+
+    loadedAt = now;
+    stale = false;
+    rebuild(now);
+}
+
+void PriceIndex::rebuild(const QDateTime &now)
+{
+    current.clear();
+    nextBoundary = QDateTime();
+
+    auto updateBoundary = [&](const QDateTime &boundary) {
+        if (boundary.isValid() && boundary > now && (!nextBoundary.isValid() || boundary < nextBoundary)) {
+            nextBoundary = boundary;
+        }
+    };
+
+    for (auto it = intervals.cbegin(); it != intervals.cend(); ++it) {
+        const QVector<Interval> &list = it.value();
+
+        // С конца: первый начавшийся и не закончившийся интервал - самый поздний по началу
+        bool found = false;
+        for (int i = list.size() - 1; i >= 0; i--) {
+            const Interval &interval = list[i];
+            if (interval.validFrom > now) {
+                updateBoundary(interval.validFrom);
+                continue;
+            }
+            if (interval.validTo.isValid() && interval.validTo <= now) {
+                continue;
+            }
+            if (!found) {
+                current.insert(it.key(), interval.price);
+                found = true;
+            }
+            updateBoundary(interval.validTo);
+        }
+    }
+}
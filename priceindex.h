@@ -0,0 +1,53 @@
+#ifndef PRICEINDEX_H
+#define PRICEINDEX_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include "database.h"
+#include "money.h"
+
+// Действующие цены из прайс-листов.
+//
+// Интервалы всех незакончившихся прайс-листов держатся в памяти по товарам,
+// отсортированные по началу действия. Из них один раз собирается таблица
+// цен на текущий момент и время ближайшей границы интервала; до этой
+// границы цена товара - поиск в хеше без запросов к базе. Когда граница
+// пройдена, таблица пересобирается из памяти, новые прайс-листы из базы
+// перечитываются после invalidate() или раз в RELOAD_INTERVAL_SECS.
+//
+// Если интервалы пересекаются, действует прайс-лист с более поздним началом.
+class PriceIndex
+{
+public:
+    static PriceIndex &instance();
+
+    Money price(Database &db, int productId, double basePrice);
+    void apply(Database &db, QList<Product> &products);
+
+    void invalidate();
+
+private:
+    PriceIndex();
+
+    struct Interval {
+        QDateTime validFrom;
+        QDateTime validTo;
+        int priceListId;
+        Money price;
+    };
+
+    void ensureCurrent(Database &db, const QDateTime &now);
+    void reload(Database &db, const QDateTime &now);
+    void rebuild(const QDateTime &now);
+
+    QHash<int, QVector<Interval>> intervals;
+    QHash<int, Money> current;
+    QDateTime loadedAt;
+    QDateTime nextBoundary;
+    bool stale;
+    QMutex mutex;
+};
+
+#endif // PRICEINDEX_H
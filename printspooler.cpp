@@ -0,0 +1,153 @@
+#include "printspooler.h"
+#include "receiptrenderer.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QPrinter>
+#include <QTextDocument>
+
+static const int MAX_ATTEMPTS = 3;
+static const int RETRY_DELAY_MS = 2000;
+
+PrintSpooler &PrintSpooler::instance()
+{
+    static PrintSpooler *spooler = nullptr;
+    if (!spooler) {
+        spooler = new PrintSpooler(qApp);
+        connect(qApp, &QCoreApplication::aboutToQuit, spooler, &PrintSpooler::shutdown);
+        spooler->start(QThread::LowPriority);
+    }
+    return *spooler;
+}
+
+PrintSpooler::PrintSpooler(QObject *parent)
+    : QThread(parent)
+    , nextJobId(1)
+    , stopping(false)
+    , renderedCount(0)
+    , renderTotalMs(0)
+    , renderLastMs(0)
+{
+}
+
+qint64 PrintSpooler::enqueue(const Receipt &receipt, const QString &printerName, const QString &outputFile)
+{
+    int depth;
+    qint64 jobId;
+    {
+        QMutexLocker locker(&mutex);
+        jobId = nextJobId++;
+        jobs.enqueue({jobId, receipt, printerName, outputFile, 0, QDateTime()});
+        depth = jobs.size();
+        condition.wakeOne();
+    }
+
+    emit queueChanged(depth);
+    return jobId;
+}
+
+int PrintSpooler::queueDepth() const
+{
+    QMutexLocker locker(&mutex);
+    return jobs.size();
+}
+
+double PrintSpooler::averageRenderMs() const
+{
+    QMutexLocker locker(&mutex);
+    return renderedCount > 0 ? double(renderTotalMs) / renderedCount : 0.0;
+}
+
+qint64 PrintSpooler::lastRenderMs() const
+{
+    QMutexLocker locker(&mutex);
+    return renderLastMs;
+}
+
+void PrintSpooler::shutdown()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopping = true;
+        condition.wakeAll();
+    }
+
+    // Текущее задание допечатывается, остальные пропадают вместе с очередью
+    wait();
+}
+
+void PrintSpooler::run()
+{
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker locker(&mutex);
+            while (!stopping) {
+                if (!jobs.isEmpty()) {
+                    qint64 delay = jobs.head().notBefore.isValid()
+                        ? QDateTime::currentDateTime().msecsTo(jobs.head().notBefore) : 0;
+                    if (delay <= 0) {
+                        break;
+                    }
+                    condition.wait(&mutex, static_cast<unsigned long>(delay));
+                } else {
+                    condition.wait(&mutex);
+                }
+            }
+
+            if (stopping) {
+                return;
+            }
+
+            job = jobs.dequeue();
+        }
+
+        QString error;
+        bool ok = process(job, error);
+        int depth;
+
+        {
+            QMutexLocker locker(&mutex);
+            if (!ok && ++job.attempts < MAX_ATTEMPTS) {
+                job.notBefore = QDateTime::currentDateTime().addMSecs(RETRY_DELAY_MS * job.attempts);
+                jobs.enqueue(job);
+                qDebug() << "Print job" << job.id << "failed, retry" << job.attempts << ":" << error;
+            }
+            depth = jobs.size();
+        }
+
+        emit queueChanged(depth);
+        if (ok || job.attempts >= MAX_ATTEMPTS) {
+            emit jobFinished(job.id, ok, error);
+        }
+    }
+}
+
+bool PrintSpooler::process(const Job &job, QString &error)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QTextDocument document;
+    document.setHtml(ReceiptRenderer::html(job.receipt));
+
+    qint64 elapsed = timer.elapsed();
+    {
+        QMutexLocker locker(&mutex);
+        renderedCount++;
+        renderTotalMs += elapsed;
+        renderLastMs = elapsed;
+    }
+
+    QPrinter printer(QPrinter::HighResolution);
+    ReceiptRenderer::setupPage(printer);
+
+    if (!job.outputFile.isEmpty()) {
+        printer.setOutputFormat(QPrinter::PdfFormat);
+        printer.setOutputFileName(job.outputFile);
+    } else if (!job.printerName.isEmpty()) {
+        printer.setPrinterName(job.printerName);
+    }
+
+    return ReceiptRenderer::print(document, printer, error);
+}
@@ -0,0 +1,63 @@
+#ifndef PRINTSPOOLER_H
+#define PRINTSPOOLER_H
+
+#include <QDateTime>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+#include "receiptcache.h"
+
+// Очередь печати чеков. Один фоновый поток собирает HTML по шаблонам
+// и печатает на принтер или в PDF, кассовое окно при этом не ждет.
+// Неудачное задание повторяется с нарастающей паузой до MAX_ATTEMPTS раз.
+class PrintSpooler : public QThread
+{
+    Q_OBJECT
+
+public:
+    static PrintSpooler &instance();
+
+    // outputFile не пустой - печать в PDF, иначе на принтер printerName
+    // (пустое имя - принтер по умолчанию). Возвращает номер задания.
+    qint64 enqueue(const Receipt &receipt, const QString &printerName, const QString &outputFile = QString());
+
+    int queueDepth() const;
+    double averageRenderMs() const;
+    qint64 lastRenderMs() const;
+
+    void shutdown();
+
+signals:
+    void jobFinished(qint64 jobId, bool success, const QString &error);
+    void queueChanged(int depth);
+
+protected:
+    void run() override;
+
+private:
+    explicit PrintSpooler(QObject *parent = nullptr);
+
+    struct Job {
+        qint64 id;
+        Receipt receipt;
+        QString printerName;
+        QString outputFile;
+        int attempts;
+        QDateTime notBefore;
+    };
+
+    bool process(const Job &job, QString &error);
+
+    mutable QMutex mutex;
+    QWaitCondition condition;
+    QQueue<Job> jobs;
+    qint64 nextJobId;
+    bool stopping;
+
+    qint64 renderedCount;
+    qint64 renderTotalMs;
+    qint64 renderLastMs;
+};
+
+#endif // PRINTSPOOLER_H
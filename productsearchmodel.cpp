@@ -0,0 +1,88 @@
+#include "productsearchmodel.h"
+
+ProductSearchModel::ProductSearchModel(Database &db, QObject *parent)
+    : QAbstractListModel(parent)
+    , db(&db)
+    , exhausted(true)
+{
+}
+
+void ProductSearchModel::setPrefix(const QString &prefix)
+{
+    QString trimmed = prefix.trimmed();
+    if (trimmed == this->prefix) {
+        return;
+    }
+
+    this->prefix = trimmed;
+    refresh();
+}
+
+void ProductSearchModel::refresh()
+{
+    beginResetModel();
+    products.clear();
+    exhausted = prefix.isEmpty();
+    endResetModel();
+
+    if (!exhausted) {
+        fetchMore(QModelIndex());
+    }
+}
+
+Product ProductSearchModel::product(int row) const
+{
+    if (row < 0 || row >= products.size()) {
+        Product none;
+        none.id = -1;
+        return none;
+    }
+    return products.at(row);
+}
+
+int ProductSearchModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : products.size();
+}
+
+QVariant ProductSearchModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= products.size()) {
+        return QVariant();
+    }
+
+    const Product &product = products.at(index.row());
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return product.name + " (" + product.article + ")";
+    case ProductIdRole:
+        return product.id;
+    }
+
+    return QVariant();
+}
+
+bool ProductSearchModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !exhausted;
+}
+
+void ProductSearchModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || exhausted) {
+        return;
+    }
+
+    QList<Product> page = db->searchProducts(prefix, products.size(), PAGE_SIZE);
+    exhausted = page.size() < PAGE_SIZE;
+
+    if (page.isEmpty()) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), products.size(), products.size() + page.size() - 1);
+    products += page;
+    endInsertRows();
+}
@@ -0,0 +1,42 @@
+#ifndef PRODUCTSEARCHMODEL_H
+#define PRODUCTSEARCHMODEL_H
+
+#include <QAbstractListModel>
+#include "database.h"
+
+// Товары, у которых название или артикул начинается с введенного текста,
+// для QCompleter. Из базы читаются только совпадения, страницами по
+// PAGE_SIZE по мере прокрутки списка; при пустом тексте модель пуста,
+// поэтому размер каталога не влияет на открытие формы.
+class ProductSearchModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        ProductIdRole = Qt::UserRole
+    };
+
+    static const int PAGE_SIZE = 50;
+
+    ProductSearchModel(Database &db, QObject *parent = nullptr);
+
+    void setPrefix(const QString &prefix);
+    void refresh();
+
+    Product product(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    Database *db;
+    QString prefix;
+    QList<Product> products;
+    bool exhausted;
+};
+
+#endif // PRODUCTSEARCHMODEL_H
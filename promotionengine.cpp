@@ -0,0 +1,183 @@
+#include "promotionengine.h"
+#include <QVarLengthArray>
+#include <algorithm>
+
+// Правила могли поменять в таблице: собранный набор живет не дольше этого
+static const int RELOAD_INTERVAL_SECS = 300;
+
+void PromotionResult::addManualDiscount(double percent)
+{
+    if (percent <= 0) {
+        return;
+    }
+
+    discount += total.percent(percent);
+    total = subtotal - discount;
+    applied.append(QString("Скидка %1%").arg(percent));
+}
+
+double PromotionResult::percent() const
+{
+    if (subtotal.minor() == 0) {
+        return 0.0;
+    }
+    return qRound(discount.minor() * 10000.0 / subtotal.minor()) / 100.0;
+}
+
+static bool inHourWindow(int hour, int from, int to)
+{
+    if (from < 0 || to < 0) {
+        return true;
+    }
+    // Окно через полночь, например с 22 до 6
+    return from <= to ? (hour >= from && hour < to) : (hour >= from || hour < to);
+}
+
+static void updateExpiry(QDateTime &expiresAt, const QDateTime &boundary)
+{
+    if (boundary.isValid() && (!expiresAt.isValid() || boundary < expiresAt)) {
+        expiresAt = boundary;
+    }
+}
+
+PromotionEngine::PromotionEngine(const QList<PromotionRule> &rules, const QDateTime &at)
+    : compiledAt(at)
+{
+    QDateTime nextHour(at.date(), QTime(at.time().hour(), 0));
+    nextHour = nextHour.addSecs(3600);
+    expiresAt = at.addSecs(RELOAD_INTERVAL_SECS);
+
+    for (const PromotionRule &rule : rules) {
+        if (rule.hourFrom >= 0 && rule.hourTo >= 0) {
+            updateExpiry(expiresAt, nextHour);
+        }
+
+        if (rule.validFrom.isValid() && at < rule.validFrom) {
+            updateExpiry(expiresAt, rule.validFrom);
+            continue;
+        }
+        if (rule.validTo.isValid()) {
+            if (at >= rule.validTo) {
+                continue;
+            }
+            updateExpiry(expiresAt, rule.validTo);
+        }
+        if (!inHourWindow(at.time().hour(), rule.hourFrom, rule.hourTo)) {
+            continue;
+        }
+
+        switch (rule.kind) {
+        case PromotionRule::QuantityTier:
+            tiers.append({qMax(rule.minQuantity, 1), rule.percent, rule.name});
+            break;
+        case PromotionRule::CategoryDiscount: {
+            auto it = categoryRules.find(rule.categoryId);
+            if (it == categoryRules.end() || it->percent < rule.percent) {
+                categoryRules.insert(rule.categoryId, {rule.percent, rule.name});
+            }
+            break;
+        }
+        case PromotionRule::Bundle:
+            if (rule.productId > 0 && rule.bundleProductId > 0 && rule.productId != rule.bundleProductId) {
+                bundles.append({rule.productId, rule.bundleProductId, rule.percent, rule.name});
+            }
+            break;
+        }
+    }
+
+    // Ступени по убыванию порога: при расчете берется первая подходящая
+    std::sort(tiers.begin(), tiers.end(), [](const Tier &a, const Tier &b) {
+        return a.minQuantity > b.minQuantity;
+    });
+
+    // Товар участвует не более чем в одном комплекте, первом по порядку правил
+    for (int i = 0; i < bundles.size(); i++) {
+        if (!bundleSlots.contains(bundles[i].productId) && !bundleSlots.contains(bundles[i].bundleProductId)) {
+            bundleSlots.insert(bundles[i].productId, 2 * i);
+            bundleSlots.insert(bundles[i].bundleProductId, 2 * i + 1);
+        }
+    }
+}
+
+PromotionEngine PromotionEngine::load(Database &db, const QDateTime &at)
+{
+    return PromotionEngine(db.getActivePromotions(), at);
+}
+
+bool PromotionEngine::isCurrent(const QDateTime &now) const
+{
+    return compiledAt.isValid() && now >= compiledAt && (!expiresAt.isValid() || now < expiresAt);
+}
+
+PromotionResult PromotionEngine::evaluate(const QVector<BasketLine> &basket) const
+{
+    PromotionResult result;
+
+    // Для комплектов: количество и цена каждой из двух сторон
+    QVector<qint64> slotQuantity(bundles.size() * 2, 0);
+    QVector<Money> slotPrice(bundles.size() * 2);
+
+    // Цены и количества раскладываются в непрерывные массивы:
+    // суммы строк и подытог считают векторные ядра Money
+    const int count = basket.size();
+    QVarLengthArray<qint64, 64> prices(count);
+    QVarLengthArray<qint32, 64> quantities(count);
+    QVarLengthArray<qint64, 64> lineTotals(count);
+
+    for (int i = 0; i < count; i++) {
+        prices[i] = basket[i].unitPrice.minor();
+        quantities[i] = basket[i].quantity;
+        result.quantity += basket[i].quantity;
+    }
+
+    Money::lineTotals(prices.data(), quantities.data(), lineTotals.data(), count);
+    result.subtotal = Money::sum(lineTotals.data(), count);
+
+    Money lineDiscounts;
+
+    if (!categoryRules.isEmpty() || !bundleSlots.isEmpty()) {
+        for (int i = 0; i < count; i++) {
+            const BasketLine &line = basket[i];
+
+            if (!categoryRules.isEmpty()) {
+                auto it = categoryRules.constFind(line.categoryId);
+                if (it != categoryRules.constEnd()) {
+                    lineDiscounts += Money::fromMinor(lineTotals[i]).percent(it->percent);
+                    if (!result.applied.contains(it->name)) {
+                        result.applied.append(it->name);
+                    }
+                }
+            }
+
+            if (!bundleSlots.isEmpty()) {
+                auto it = bundleSlots.constFind(line.productId);
+                if (it != bundleSlots.constEnd()) {
+                    slotQuantity[*it] += line.quantity;
+                    slotPrice[*it] = line.unitPrice;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < bundles.size(); i++) {
+        qint64 sets = qMin(slotQuantity[2 * i], slotQuantity[2 * i + 1]);
+        if (sets > 0) {
+            lineDiscounts += ((slotPrice[2 * i] + slotPrice[2 * i + 1]) * sets).percent(bundles[i].percent);
+            result.applied.append(bundles[i].name);
+        }
+    }
+
+    Money remaining = result.subtotal - qMin(lineDiscounts, result.subtotal);
+    result.discount = result.subtotal - remaining;
+
+    for (const Tier &tier : tiers) {
+        if (result.quantity >= tier.minQuantity) {
+            result.discount += remaining.percent(tier.percent);
+            result.applied.append(tier.name);
+            break;
+        }
+    }
+
+    result.total = result.subtotal - result.discount;
+    return result;
+}
@@ -0,0 +1,82 @@
+#ifndef PROMOTIONENGINE_H
+#define PROMOTIONENGINE_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include "database.h"
+#include "money.h"
+
+struct BasketLine {
+    int productId;
+    int categoryId;
+    Money unitPrice;
+    int quantity;
+};
+
+struct PromotionResult {
+    Money subtotal;
+    Money discount;
+    Money total;
+    int quantity = 0;
+    QStringList applied;
+
+    // Скидка кассира в процентах поверх правил
+    void addManualDiscount(double percent);
+
+    // Итоговая скидка в процентах от суммы, для колонки sales.discount_amount
+    double percent() const;
+};
+
+// Скидки по правилам из таблицы promotions.
+//
+// Правила компилируются на момент времени: неактивные в этот момент
+// отбрасываются, ступени по количеству сортируются, правила категорий
+// и комплектов раскладываются в хеши по категории и товару. Корзина
+// после этого считается за один проход по строкам.
+//
+// Скидки складываются: сначала по строкам (категория, комплект),
+// затем ступень по количеству товаров на оставшуюся сумму.
+class PromotionEngine
+{
+public:
+    PromotionEngine() = default;
+    explicit PromotionEngine(const QList<PromotionRule> &rules,
+                             const QDateTime &at = QDateTime::currentDateTime());
+
+    static PromotionEngine load(Database &db, const QDateTime &at = QDateTime::currentDateTime());
+
+    PromotionResult evaluate(const QVector<BasketLine> &basket) const;
+
+    // false, когда набор действующих правил пора собрать заново
+    bool isCurrent(const QDateTime &now = QDateTime::currentDateTime()) const;
+
+private:
+    struct Tier {
+        int minQuantity;
+        double percent;
+        QString name;
+    };
+
+    struct LineRule {
+        double percent;
+        QString name;
+    };
+
+    struct BundleRule {
+        int productId;
+        int bundleProductId;
+        double percent;
+        QString name;
+    };
+
+    QVector<Tier> tiers;
+    QHash<int, LineRule> categoryRules;
+    QVector<BundleRule> bundles;
+    QHash<int, int> bundleSlots;
+    QDateTime compiledAt;
+    QDateTime expiresAt;
+};
+
+#endif // PROMOTIONENGINE_H
@@ -0,0 +1,253 @@
+#include "receiptbatchexporter.h"
+#include "database.h"
+#include "receiptcache.h"
+#include "receiptrenderer.h"
+#include <QAbstractTextDocumentLayout>
+#include <QDir>
+#include <QFile>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QRegularExpression>
+#include <QTextDocument>
+#include <QtConcurrent>
+
+static const int BATCH_SIZE = 64;
+static const int PDF_RESOLUTION = 300;
+
+struct ReceiptFileJob {
+    Receipt receipt;
+    QString path;
+};
+
+static void setupWriter(QPdfWriter &writer)
+{
+    writer.setResolution(PDF_RESOLUTION);
+    writer.setCreator("HouseholdsGoodsStore");
+    ReceiptRenderer::setupPage(writer);
+}
+
+// Выполняется в пуле: каждый чек целиком оформляется и пишется своим потоком
+static QString writeReceiptFile(const ReceiptFileJob &job)
+{
+    {
+        QPdfWriter writer(job.path);
+        setupWriter(writer);
+
+        QTextDocument document;
+        document.setHtml(ReceiptRenderer::html(job.receipt));
+        document.print(&writer);
+    }
+
+    QFile file(job.path);
+    if (!file.exists() || file.size() == 0) {
+        return QString("Не удалось записать файл %1").arg(job.path);
+    }
+    return QString();
+}
+
+// Чек в общий файл: страницы документа рисуются подряд одним QPainter
+static void paintReceipt(QPainter &painter, QPdfWriter &writer, const QString &html, bool &firstPage)
+{
+    QTextDocument document;
+    document.documentLayout()->setPaintDevice(&writer);
+    document.setHtml(html);
+
+    QSizeF pageSize = writer.pageLayout().paintRectPixels(writer.resolution()).size();
+    document.setPageSize(pageSize);
+
+    for (int page = 0; page < document.pageCount(); page++) {
+        if (!firstPage) {
+            writer.newPage();
+        }
+        firstPage = false;
+
+        QRectF clip(0, page * pageSize.height(), pageSize.width(), pageSize.height());
+        painter.save();
+        painter.translate(0, -clip.top());
+        document.drawContents(&painter, clip);
+        painter.restore();
+    }
+}
+
+static QString receiptFileName(const Sale &sale)
+{
+    QString name = sale.receiptNumber;
+    name.replace(QRegularExpression("[^\\w\\-]"), "_");
+    if (name.isEmpty()) {
+        name = QString::number(sale.id);
+    }
+    return name + ".pdf";
+}
+
+ReceiptBatchExporter::ReceiptBatchExporter(const QDate &startDate, const QDate &endDate, int cashierId,
+                                           Mode mode, const QString &targetPath, QObject *parent)
+    : QThread(parent)
+    , startDate(startDate)
+    , endDate(endDate)
+    , cashierId(cashierId)
+    , mode(mode)
+    , targetPath(targetPath)
+    , success(false)
+    , writtenReceipts(0)
+{
+}
+
+void ReceiptBatchExporter::run()
+{
+    success = false;
+    writtenReceipts = 0;
+
+    Database db;
+    if (!db.connectToDatabase()) {
+        error = "Не удалось подключиться к базе данных";
+        return;
+    }
+
+    QSqlQuery query;
+    if (!db.openReceiptQuery(startDate, endDate, cashierId, query)) {
+        error = "Ошибка чтения из базы данных: " + db.lastError().text();
+        return;
+    }
+
+    QDir targetDir(targetPath);
+    QPdfWriter *writer = nullptr;
+    QPainter painter;
+    bool firstPage = true;
+
+    if (mode == SingleFile) {
+        writer = new QPdfWriter(targetPath);
+        setupWriter(*writer);
+        if (!painter.begin(writer)) {
+            error = QString("Не удалось создать файл %1").arg(targetPath);
+            delete writer;
+            return;
+        }
+    } else if (!targetDir.exists() && !targetDir.mkpath(".")) {
+        error = QString("Не удалось создать каталог %1").arg(targetPath);
+        return;
+    }
+
+    qint64 totalDays = qMax<qint64>(startDate.daysTo(endDate) + 1, 1);
+    int lastPercent = -1;
+    bool failed = false;
+
+    QList<Receipt> batch;
+    batch.reserve(BATCH_SIZE);
+    Receipt current;
+    current.sale.id = -1;
+
+    auto flush = [&]() {
+        if (batch.isEmpty()) {
+            return;
+        }
+
+        if (mode == SingleFile) {
+            const QStringList pages = QtConcurrent::blockingMapped<QStringList>(batch, ReceiptRenderer::html);
+            for (const QString &html : pages) {
+                paintReceipt(painter, *writer, html, firstPage);
+            }
+        } else {
+            QList<ReceiptFileJob> jobs;
+            jobs.reserve(batch.size());
+            for (const Receipt &receipt : batch) {
+                jobs.append({receipt, targetDir.filePath(receiptFileName(receipt.sale))});
+            }
+
+            const QStringList errors = QtConcurrent::blockingMapped<QStringList>(jobs, writeReceiptFile);
+            for (const QString &jobError : errors) {
+                if (!jobError.isEmpty()) {
+                    error = jobError;
+                    failed = true;
+                    return;
+                }
+            }
+        }
+
+        writtenReceipts += batch.size();
+
+        int percent = static_cast<int>(qBound<qint64>(
+            0, startDate.daysTo(batch.last().sale.saleDate.date()) * 100 / totalDays, 100));
+        if (percent != lastPercent) {
+            lastPercent = percent;
+            emit progress(percent);
+        }
+
+        batch.clear();
+    };
+
+    while (!failed && query.next()) {
+        int saleId = query.value(0).toInt();
+
+        if (saleId != current.sale.id) {
+            if (current.sale.id != -1) {
+                batch.append(current);
+                if (batch.size() >= BATCH_SIZE) {
+                    if (isInterruptionRequested()) {
+                        error = "Выгрузка отменена";
+                        failed = true;
+                        break;
+                    }
+                    flush();
+                }
+            }
+
+            current = Receipt();
+            Sale &sale = current.sale;
+            sale.id = saleId;
+            sale.receiptNumber = query.value(1).toString();
+            sale.saleDate = query.value(2).toDateTime();
+            sale.cashierId = query.value(3).toInt();
+            sale.cashierName = query.value(4).toString();
+            sale.customerId = query.value(5).toInt();
+            sale.customerName = query.value(6).toString();
+            sale.totalAmount = query.value(7).toDouble();
+            sale.discountAmount = query.value(8).toDouble();
+            sale.finalAmount = query.value(9).toDouble();
+            sale.createdAt = query.value(10).toDateTime();
+        }
+
+        if (!query.isNull(11)) {
+            SaleItem item;
+            item.id = query.value(11).toInt();
+            item.saleId = saleId;
+            item.productId = query.value(12).toInt();
+            item.productName = query.value(13).toString();
+            item.quantity = query.value(14).toInt();
+            item.retailPrice = query.value(15).toDouble();
+            item.totalPrice = query.value(16).toDouble();
+            current.items.append(item);
+        }
+    }
+
+    if (!failed && query.lastError().isValid()) {
+        error = "Ошибка чтения из базы данных: " + query.lastError().text();
+        failed = true;
+    }
+
+    if (!failed) {
+        if (current.sale.id != -1) {
+            batch.append(current);
+        }
+        flush();
+    }
+    query.finish();
+
+    if (writer) {
+        painter.end();
+        delete writer;
+
+        if (failed || writtenReceipts == 0) {
+            QFile::remove(targetPath);
+        }
+    }
+
+    if (!failed && writtenReceipts == 0) {
+        error = "За выбранный период чеков нет";
+        return;
+    }
+
+    if (!failed) {
+        emit progress(100);
+    }
+    success = !failed;
+}
@@ -0,0 +1,49 @@
+#ifndef RECEIPTBATCHEXPORTER_H
+#define RECEIPTBATCHEXPORTER_H
+
+#include <QDate>
+#include <QThread>
+#include <QString>
+
+// Выгрузка чеков за период в PDF для проверяющих.
+// Продажи и позиции читаются одним запросом, чеки собираются пачками
+// по BATCH_SIZE и оформляются в пуле QtConcurrent; в памяти одновременно
+// только одна пачка. Режимы: один многостраничный файл или по файлу на чек.
+class ReceiptBatchExporter : public QThread
+{
+    Q_OBJECT
+
+public:
+    enum Mode {
+        SingleFile,
+        FilePerReceipt
+    };
+
+    // targetPath - файл для SingleFile или каталог для FilePerReceipt;
+    // cashierId <= 0 - чеки всех кассиров
+    ReceiptBatchExporter(const QDate &startDate, const QDate &endDate, int cashierId,
+                         Mode mode, const QString &targetPath, QObject *parent = nullptr);
+
+    bool succeeded() const { return success; }
+    QString errorString() const { return error; }
+    int receiptsWritten() const { return writtenReceipts; }
+
+signals:
+    void progress(int percent);
+
+protected:
+    void run() override;
+
+private:
+    QDate startDate;
+    QDate endDate;
+    int cashierId;
+    Mode mode;
+    QString targetPath;
+
+    bool success;
+    QString error;
+    int writtenReceipts;
+};
+
+#endif // RECEIPTBATCHEXPORTER_H
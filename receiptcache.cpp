@@ -0,0 +1,52 @@
+#include "receiptcache.h"
+#include <QMutexLocker>
+
+static const int MAX_CACHED_RECEIPTS = 200;
+
+ReceiptCache &ReceiptCache::instance()
+{
+    static ReceiptCache receiptCache;
+    return receiptCache;
+}
+
+ReceiptCache::ReceiptCache()
+    : cache(MAX_CACHED_RECEIPTS)
+{
+}
+
+Receipt ReceiptCache::receipt(int saleId)
+{
+    {
+        QMutexLocker locker(&mutex);
+        if (Receipt *cached = cache.object(saleId)) {
+            return *cached;
+        }
+    }
+
+    Receipt loaded;
+    loaded.sale.id = -1;
+
+    Database db;
+    if (!db.connectToDatabase()) {
+        return loaded;
+    }
+
+    loaded.sale = db.getSaleDetails(saleId);
+    if (loaded.sale.id == -1) {
+        return loaded;
+    }
+    loaded.items = db.getSaleItems(saleId);
+
+    insert(loaded);
+    return loaded;
+}
+
+void ReceiptCache::insert(const Receipt &receipt)
+{
+    if (receipt.sale.id <= 0) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+    cache.insert(receipt.sale.id, new Receipt(receipt));
+}
@@ -0,0 +1,31 @@
+#ifndef RECEIPTCACHE_H
+#define RECEIPTCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include "database.h"
+
+// Данные чека для показа и печати: шапка продажи и строки
+struct Receipt {
+    Sale sale;
+    QList<SaleItem> items;
+};
+
+// Недавно открытые чеки. Проданный чек не меняется, поэтому записи
+// не устаревают и вытесняются только по давности использования.
+class ReceiptCache
+{
+public:
+    static ReceiptCache &instance();
+
+    Receipt receipt(int saleId);
+    void insert(const Receipt &receipt);
+
+private:
+    ReceiptCache();
+
+    QCache<int, Receipt> cache;
+    QMutex mutex;
+};
+
+#endif // RECEIPTCACHE_H
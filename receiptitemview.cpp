@@ -0,0 +1,82 @@
+#include "receiptitemview.h"
+#include "money.h"
+#include <QPainter>
+
+static const int ROW_MARGIN = 2;
+static const int COLUMN_SPACING = 8;
+
+ReceiptItemsModel::ReceiptItemsModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+void ReceiptItemsModel::setItems(const QList<SaleItem> &items)
+{
+    beginResetModel();
+    this->items = items;
+    endResetModel();
+}
+
+int ReceiptItemsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : items.size();
+}
+
+QVariant ReceiptItemsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= items.size()) {
+        return QVariant();
+    }
+
+    const SaleItem &item = items.at(index.row());
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::ToolTipRole:
+        return item.productName;
+    case DetailsRole:
+        return QString("%1 x %2").arg(item.quantity).arg(Money::fromDouble(item.retailPrice).toString());
+    }
+
+    return QVariant();
+}
+
+ReceiptItemDelegate::ReceiptItemDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+    , cachedMetrics(cachedFont)
+{
+}
+
+const QFontMetrics &ReceiptItemDelegate::metricsFor(const QFont &font) const
+{
+    if (font != cachedFont) {
+        cachedFont = font;
+        cachedMetrics = QFontMetrics(font);
+    }
+    return cachedMetrics;
+}
+
+void ReceiptItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                                const QModelIndex &index) const
+{
+    const QFontMetrics &metrics = metricsFor(option.font);
+    QRect rect = option.rect.adjusted(0, ROW_MARGIN, 0, -ROW_MARGIN);
+
+    QString details = index.data(ReceiptItemsModel::DetailsRole).toString();
+    int detailsWidth = metrics.horizontalAdvance(details);
+    int nameWidth = qMax(0, rect.width() - detailsWidth - COLUMN_SPACING);
+    QString name = metrics.elidedText(index.data(Qt::DisplayRole).toString(), Qt::ElideRight, nameWidth);
+
+    painter->save();
+    painter->setFont(option.font);
+    painter->setPen(option.palette.color(QPalette::WindowText));
+    painter->drawText(rect, Qt::AlignLeft | Qt::AlignVCenter, name);
+    painter->drawText(rect, Qt::AlignRight | Qt::AlignVCenter, details);
+    painter->restore();
+}
+
+QSize ReceiptItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    Q_UNUSED(index);
+    return QSize(0, metricsFor(option.font).height() + 2 * ROW_MARGIN);
+}
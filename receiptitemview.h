@@ -0,0 +1,51 @@
+#ifndef RECEIPTITEMVIEW_H
+#define RECEIPTITEMVIEW_H
+
+#include <QAbstractListModel>
+#include <QFontMetrics>
+#include <QStyledItemDelegate>
+#include "database.h"
+
+// Позиции чека для QListView. Строки не создают виджетов:
+// модель отдает данные, делегат рисует видимые строки сам.
+class ReceiptItemsModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        DetailsRole = Qt::UserRole + 1
+    };
+
+    explicit ReceiptItemsModel(QObject *parent = nullptr);
+
+    void setItems(const QList<SaleItem> &items);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    QList<SaleItem> items;
+};
+
+// Название слева, "количество x цена" справа. Высота строки одна на все
+// строки и считается один раз для шрифта, поэтому при открытии большого
+// чека вид не измеряет каждую строку.
+class ReceiptItemDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit ReceiptItemDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+private:
+    const QFontMetrics &metricsFor(const QFont &font) const;
+
+    mutable QFont cachedFont;
+    mutable QFontMetrics cachedMetrics;
+};
+
+#endif // RECEIPTITEMVIEW_H
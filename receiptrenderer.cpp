@@ -0,0 +1,198 @@
+#include "receiptrenderer.h"
+#include "money.h"
+#include <QPageLayout>
+#include <QPageSize>
+#include <QPrinter>
+#include <QTextDocument>
+#include <QVector>
+
+enum ReceiptField {
+    FieldReceiptNumber,
+    FieldSaleDate,
+    FieldCashier,
+    FieldCustomer,
+    FieldCustomerLine,
+    FieldItems,
+    FieldItemName,
+    FieldItemQuantity,
+    FieldItemTotal,
+    FieldTotal,
+    FieldDiscount,
+    FieldDiscountLine,
+    FieldFinalAmount,
+    FieldCount
+};
+
+static const char *const fieldNames[FieldCount] = {
+    "receipt_number", "sale_date", "cashier", "customer", "customer_line", "items",
+    "item_name", "item_quantity", "item_total", "total", "discount", "discount_line", "final_amount"
+};
+
+static const char *const documentSource =
+    "<html><body style='font-family: Arial, sans-serif;'>"
+    "<div style='text-align: center; font-size: 14pt; font-weight: bold;'>"
+    "МАГАЗИН БЫТОВЫХ ТОВАРОВ<br>"
+    "ЧЕК ПРОДАЖИ<br><br>"
+    "</div>"
+    "<div style='font-size: 10pt;'>"
+    "Чек №: {{receipt_number}}<br>"
+    "Дата: {{sale_date}}<br>"
+    "Кассир: {{cashier}}<br>"
+    "{{customer_line}}"
+    "<hr>"
+    "</div>"
+    "<table width='100%' border='1' cellpadding='2' cellspacing='0' style='font-size: 10pt;'>"
+    "<tr style='background-color: #f0f0f0; font-weight: bold;'>"
+    "<td>Товар</td><td align='center'>Кол-во</td><td align='right'>Сумма</td>"
+    "</tr>"
+    "{{items}}"
+    "</table>"
+    "<div style='text-align: right; font-size: 10pt; margin-top: 10px;'>"
+    "Итого: {{total}} руб.<br>"
+    "{{discount_line}}"
+    "<b>К ОПЛАТЕ: {{final_amount}} руб.</b><br>"
+    "</div>"
+    "<div style='text-align: center; margin-top: 20px; font-size: 10pt;'>"
+    "<hr>"
+    "<div style='font-size: 12pt; font-weight: bold;'>СПАСИБО ЗА ПОКУПКУ!</div>"
+    "________________<br>"
+    "Подпись кассира"
+    "</div>"
+    "</body></html>";
+
+static const char *const itemSource =
+    "<tr>"
+    "<td>{{item_name}}</td>"
+    "<td align='center'>{{item_quantity}}</td>"
+    "<td align='right'>{{item_total}}</td>"
+    "</tr>";
+
+static const char *const customerSource = "Клиент: {{customer}}<br>";
+static const char *const discountSource = "Скидка: {{discount}} руб.<br>";
+
+// Шаблон, разобранный на постоянный текст и номера подставляемых полей
+class ReceiptTemplate
+{
+public:
+    explicit ReceiptTemplate(const char *source)
+    {
+        QString text = QString::fromUtf8(source);
+        int position = 0;
+
+        for (;;) {
+            int open = text.indexOf("{{", position);
+            int close = open < 0 ? -1 : text.indexOf("}}", open + 2);
+            if (close < 0) {
+                break;
+            }
+
+            QString name = text.mid(open + 2, close - open - 2);
+            int field = -1;
+            for (int i = 0; i < FieldCount; i++) {
+                if (name == QLatin1String(fieldNames[i])) {
+                    field = i;
+                }
+            }
+            Q_ASSERT_X(field >= 0, "ReceiptTemplate", "unknown placeholder");
+
+            segments.append({text.mid(position, open - position), field});
+            size += open - position;
+            position = close + 2;
+        }
+
+        segments.append({text.mid(position), -1});
+        size += text.size() - position;
+    }
+
+    void render(const QVector<QString> &values, QString &out) const
+    {
+        for (const Segment &segment : segments) {
+            out += segment.text;
+            if (segment.field >= 0) {
+                out += values[segment.field];
+            }
+        }
+    }
+
+    int textSize() const { return size; }
+
+private:
+    struct Segment {
+        QString text;
+        int field;
+    };
+
+    QVector<Segment> segments;
+    int size = 0;
+};
+
+QString ReceiptRenderer::html(const Receipt &receipt)
+{
+    static const ReceiptTemplate documentTemplate(documentSource);
+    static const ReceiptTemplate itemTemplate(itemSource);
+    static const ReceiptTemplate customerTemplate(customerSource);
+    static const ReceiptTemplate discountTemplate(discountSource);
+
+    const Sale &sale = receipt.sale;
+    QVector<QString> values(FieldCount);
+
+    QString &items = values[FieldItems];
+    items.reserve(receipt.items.size() * (itemTemplate.textSize() + 64));
+    for (const SaleItem &item : receipt.items) {
+        values[FieldItemName] = item.productName.toHtmlEscaped();
+        values[FieldItemQuantity] = QString::number(item.quantity);
+        values[FieldItemTotal] = Money::fromDouble(item.totalPrice).toString();
+        itemTemplate.render(values, items);
+    }
+
+    values[FieldReceiptNumber] = sale.receiptNumber.toHtmlEscaped();
+    values[FieldSaleDate] = sale.saleDate.toString("dd.MM.yyyy HH:mm");
+    values[FieldCashier] = sale.cashierName.toHtmlEscaped();
+    Money total = Money::fromDouble(sale.totalAmount);
+    Money finalAmount = Money::fromDouble(sale.finalAmount);
+    values[FieldTotal] = total.toString();
+    values[FieldFinalAmount] = finalAmount.toString();
+
+    if (!sale.customerName.isEmpty()) {
+        values[FieldCustomer] = sale.customerName.toHtmlEscaped();
+        customerTemplate.render(values, values[FieldCustomerLine]);
+    }
+
+    // discount_amount хранит проценты, в чеке скидка печатается в рублях
+    if (finalAmount < total) {
+        values[FieldDiscount] = (total - finalAmount).toString();
+        discountTemplate.render(values, values[FieldDiscountLine]);
+    }
+
+    QString out;
+    out.reserve(documentTemplate.textSize() + items.size() + 256);
+    documentTemplate.render(values, out);
+    return out;
+}
+
+void ReceiptRenderer::setupPage(QPagedPaintDevice &device)
+{
+    device.setPageSize(QPageSize(QPageSize::A5));
+    device.setPageOrientation(QPageLayout::Portrait);
+}
+
+bool ReceiptRenderer::print(QTextDocument &document, QPrinter &printer, QString &error)
+{
+    if (!printer.isValid()) {
+        error = QString("Принтер недоступен: %1").arg(printer.printerName());
+        return false;
+    }
+
+    document.print(&printer);
+
+    if (printer.printerState() == QPrinter::Error || printer.printerState() == QPrinter::Aborted) {
+        if (printer.outputFormat() == QPrinter::PdfFormat) {
+            error = QString("Не удалось записать файл %1").arg(printer.outputFileName());
+        } else {
+            error = QString("Ошибка печати на принтер %1").arg(printer.printerName());
+        }
+        return false;
+    }
+
+    return true;
+}
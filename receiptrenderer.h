@@ -0,0 +1,22 @@
+#ifndef RECEIPTRENDERER_H
+#define RECEIPTRENDERER_H
+
+#include <QString>
+#include "receiptcache.h"
+
+class QPagedPaintDevice;
+class QPrinter;
+class QTextDocument;
+
+// Вывод чека. Шаблоны HTML разбираются один раз при первом обращении,
+// дальше чек собирается подстановкой значений в готовые фрагменты.
+// Можно вызывать из любого потока.
+class ReceiptRenderer
+{
+public:
+    static QString html(const Receipt &receipt);
+    static void setupPage(QPagedPaintDevice &device);
+    static bool print(QTextDocument &document, QPrinter &printer, QString &error);
+};
+
+#endif // RECEIPTRENDERER_H
@@ -3,7 +3,9 @@
 
 #include <QDialog>
 #include <QPrinter>
-#include "database.h"
+#include "receiptcache.h"
+
+class ReceiptItemsModel;
 
 namespace Ui {
 class SalesReceiptForm;
@@ -15,6 +17,7 @@ class SalesReceiptForm : public QDialog
 
 public:
     explicit SalesReceiptForm(int saleId, QWidget *parent = nullptr);
+    explicit SalesReceiptForm(const Receipt &receipt, QWidget *parent = nullptr);
     ~SalesReceiptForm();
 
 private slots:
@@ -23,11 +26,10 @@ private slots:
 
 private:
     Ui::SalesReceiptForm *ui;
-    int saleId;
-    Database db;
+    Receipt receipt;
+    ReceiptItemsModel *itemsModel;
 
-    void loadReceiptData();
-    void addProductRow(const QString &name, int quantity, double price);
+    void showReceiptData();
 };
 
 #endif // SALESRECEIPTFORM_H
@@ -0,0 +1,563 @@
+#include "salessnapshot.h"
+#include <QDataStream>
+#include <QHash>
+#include <QSaveFile>
+#include <QSet>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+static const char SNAPSHOT_MAGIC[8] = {'H', 'G', 'S', 'S', 'N', 'A', 'P', '1'};
+static const quint32 FORMAT_VERSION = 1;
+static const int BLOCK_ROWS = 65536;
+static const qint64 NULL_INT = std::numeric_limits<qint64>::min();
+
+enum SnapshotColumnType : quint8 {
+    Int64Column = 1,
+    DoubleColumn = 2,
+    StringColumn = 3,
+    TimestampColumn = 4
+};
+
+struct SnapshotColumn {
+    const char *name;
+    SnapshotColumnType type;
+};
+
+struct SnapshotTableSpec {
+    const char *name;
+    Database::SnapshotTable table;
+    QList<SnapshotColumn> columns;
+};
+
+// Порядок таблиц важен для чтения: товары и чеки идут раньше строк чеков
+static const QList<SnapshotTableSpec> &snapshotTables()
+{
+    static const QList<SnapshotTableSpec> tables = {
+        {"products", Database::SnapshotProducts,
+         {{"id", Int64Column}, {"article", StringColumn}, {"name", StringColumn},
+          {"purchase_price", DoubleColumn}, {"retail_price", DoubleColumn}}},
+        {"sales", Database::SnapshotSales,
+         {{"id", Int64Column}, {"receipt_number", StringColumn}, {"sale_date", TimestampColumn},
+          {"cashier_id", Int64Column}, {"customer_id", Int64Column}, {"total_amount", DoubleColumn},
+          {"discount_amount", DoubleColumn}, {"final_amount", DoubleColumn}}},
+        {"sale_items", Database::SnapshotSaleItems,
+         {{"id", Int64Column}, {"sale_id", Int64Column}, {"product_id", Int64Column},
+          {"quantity", Int64Column}, {"retail_price", DoubleColumn}, {"total_price", DoubleColumn}}}
+    };
+
+    return tables;
+}
+
+template <typename T>
+static void appendRaw(QByteArray &data, T value)
+{
+    T littleEndian = qToLittleEndian(value);
+    data.append(reinterpret_cast<const char *>(&littleEndian), sizeof(T));
+}
+
+class ColumnBuffer
+{
+public:
+    explicit ColumnBuffer(SnapshotColumnType type = Int64Column)
+        : type(type)
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        data.resize(0);
+        hasStats = false;
+        minInt = maxInt = 0;
+        minDouble = maxDouble = 0;
+    }
+
+    void append(const QVariant &value)
+    {
+        if (type == StringColumn) {
+            QByteArray text = value.toString().toUtf8();
+            appendRaw<quint32>(data, static_cast<quint32>(text.size()));
+            data.append(text);
+            return;
+        }
+
+        if (type == DoubleColumn) {
+            double number = value.isNull() ? std::numeric_limits<double>::quiet_NaN() : value.toDouble();
+            if (!std::isnan(number)) {
+                minDouble = hasStats ? qMin(minDouble, number) : number;
+                maxDouble = hasStats ? qMax(maxDouble, number) : number;
+                hasStats = true;
+            }
+
+            quint64 bits;
+            std::memcpy(&bits, &number, sizeof(bits));
+            appendRaw<quint64>(data, bits);
+            return;
+        }
+
+        qint64 number = NULL_INT;
+        if (!value.isNull()) {
+            if (type == TimestampColumn) {
+                // Время записано в базе без пояснения пояса (CURRENT_TIMESTAMP - UTC),
+                // сохраняется как есть, чтобы даты в отчетах совпадали с DATE() в SQL
+                QDateTime dateTime = QDateTime::fromString(value.toString(), "yyyy-MM-dd HH:mm:ss");
+                if (!dateTime.isValid()) {
+                    dateTime = value.toDateTime();
+                }
+                if (dateTime.isValid()) {
+                    dateTime.setTimeSpec(Qt::UTC);
+                    number = dateTime.toMSecsSinceEpoch();
+                }
+            } else {
+                number = value.toLongLong();
+            }
+        }
+
+        if (number != NULL_INT) {
+            minInt = hasStats ? qMin(minInt, number) : number;
+            maxInt = hasStats ? qMax(maxInt, number) : number;
+            hasStats = true;
+        }
+        appendRaw<qint64>(data, number);
+    }
+
+    SnapshotColumnType type;
+    QByteArray data;
+    bool hasStats;
+    qint64 minInt;
+    qint64 maxInt;
+    double minDouble;
+    double maxDouble;
+};
+
+static void writeBlock(QDataStream &out, QVector<ColumnBuffer> &buffers, int rows, bool compress)
+{
+    out << quint32(rows);
+
+    for (ColumnBuffer &buffer : buffers) {
+        QByteArray payload = buffer.data;
+        quint8 compression = 0;
+
+        if (compress) {
+            QByteArray packed = qCompress(buffer.data);
+            if (packed.size() < buffer.data.size()) {
+                payload = packed;
+                compression = 1;
+            }
+        }
+
+        out << compression << quint8(buffer.hasStats ? 1 : 0);
+        if (buffer.type == DoubleColumn) {
+            out << buffer.minDouble << buffer.maxDouble;
+        } else if (buffer.type != StringColumn) {
+            out << buffer.minInt << buffer.maxInt;
+        }
+        out << quint64(payload.size());
+        out.writeRawData(payload.constData(), payload.size());
+
+        buffer.reset();
+    }
+}
+
+bool SalesSnapshot::write(Database &db, const QString &path, bool compress, QString &error)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = "Не удалось открыть файл: " + file.errorString();
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+    out.writeRawData(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    out << FORMAT_VERSION << qint64(QDateTime::currentMSecsSinceEpoch())
+        << quint32(snapshotTables().size());
+
+    for (const SnapshotTableSpec &spec : snapshotTables()) {
+        QSqlQuery query;
+        if (!db.openSnapshotQuery(spec.table, query)) {
+            error = "Ошибка чтения из базы данных: " + db.lastError().text();
+            file.cancelWriting();
+            return false;
+        }
+
+        out << QByteArray(spec.name) << quint32(spec.columns.size());
+
+        QVector<ColumnBuffer> buffers;
+        for (const SnapshotColumn &column : spec.columns) {
+            out << QByteArray(column.name) << quint8(column.type);
+            buffers.append(ColumnBuffer(column.type));
+        }
+
+        // Одновременно в памяти только текущий блок
+        int rows = 0;
+        while (query.next()) {
+            for (int i = 0; i < buffers.size(); i++) {
+                buffers[i].append(query.value(i));
+            }
+
+            if (++rows == BLOCK_ROWS) {
+                writeBlock(out, buffers, rows, compress);
+                rows = 0;
+            }
+        }
+
+        if (query.lastError().isValid()) {
+            error = "Ошибка чтения из базы данных: " + query.lastError().text();
+            file.cancelWriting();
+            return false;
+        }
+
+        if (rows > 0) {
+            writeBlock(out, buffers, rows, compress);
+        }
+        out << quint32(0);
+    }
+
+    if (out.status() != QDataStream::Ok || !file.commit()) {
+        error = "Ошибка записи файла: " + file.errorString();
+        return false;
+    }
+
+    return true;
+}
+
+struct SnapshotChunk {
+    bool compressed;
+    bool hasStats;
+    qint64 minInt;
+    qint64 maxInt;
+    double minDouble;
+    double maxDouble;
+    qint64 offset;
+    quint64 size;
+};
+
+// Последовательное чтение снимка: фрагменты блока сначала только описываются,
+// данные читаются лишь для тех, что действительно нужны
+class SnapshotReader
+{
+public:
+    bool open(const QString &path, QString &error, QDateTime &created)
+    {
+        file.setFileName(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            error = "Не удалось открыть снимок: " + file.errorString();
+            return false;
+        }
+
+        in.setDevice(&file);
+        in.setByteOrder(QDataStream::LittleEndian);
+        in.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+        char magic[sizeof(SNAPSHOT_MAGIC)];
+        quint32 version = 0;
+        qint64 createdMs = 0;
+
+        if (in.readRawData(magic, sizeof(magic)) != sizeof(magic)
+            || std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) {
+            error = "Файл не является снимком продаж";
+            return false;
+        }
+
+        in >> version >> createdMs >> tables;
+        if (version != FORMAT_VERSION) {
+            error = QString("Неподдерживаемая версия снимка: %1").arg(version);
+            return false;
+        }
+
+        created = QDateTime::fromMSecsSinceEpoch(createdMs, Qt::UTC);
+        return in.status() == QDataStream::Ok;
+    }
+
+    quint32 tableCount() const { return tables; }
+
+    bool readTableHeader(QByteArray &name, QList<QByteArray> &columnNames)
+    {
+        quint32 count = 0;
+        in >> name >> count;
+
+        columnNames.clear();
+        columnTypes.clear();
+        for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+            QByteArray columnName;
+            quint8 type = 0;
+            in >> columnName >> type;
+            columnNames.append(columnName);
+            columnTypes.append(type);
+        }
+
+        return in.status() == QDataStream::Ok;
+    }
+
+    // Число строк блока, 0 в конце таблицы, -1 при ошибке
+    int readBlock(QVector<SnapshotChunk> &chunks)
+    {
+        quint32 rows = 0;
+        in >> rows;
+        if (in.status() != QDataStream::Ok) {
+            return -1;
+        }
+        if (rows == 0) {
+            return 0;
+        }
+
+        chunks.resize(columnTypes.size());
+        for (int i = 0; i < columnTypes.size(); i++) {
+            SnapshotChunk &chunk = chunks[i];
+            quint8 compression = 0;
+            quint8 hasStats = 0;
+            in >> compression >> hasStats;
+
+            chunk.compressed = compression == 1;
+            chunk.hasStats = hasStats == 1;
+            if (columnTypes[i] == DoubleColumn) {
+                in >> chunk.minDouble >> chunk.maxDouble;
+            } else if (columnTypes[i] != StringColumn) {
+                in >> chunk.minInt >> chunk.maxInt;
+            }
+            in >> chunk.size;
+
+            chunk.offset = file.pos();
+            if (in.status() != QDataStream::Ok || !file.seek(chunk.offset + static_cast<qint64>(chunk.size))) {
+                return -1;
+            }
+        }
+
+        return static_cast<int>(rows);
+    }
+
+    bool readChunk(const SnapshotChunk &chunk, QByteArray &data)
+    {
+        qint64 position = file.pos();
+
+        if (!file.seek(chunk.offset)) {
+            return false;
+        }
+        data = file.read(static_cast<qint64>(chunk.size));
+        file.seek(position);
+
+        if (data.size() != static_cast<int>(chunk.size)) {
+            return false;
+        }
+        if (chunk.compressed) {
+            data = qUncompress(data);
+        }
+        return true;
+    }
+
+private:
+    QFile file;
+    QDataStream in;
+    quint32 tables = 0;
+    QList<quint8> columnTypes;
+};
+
+static bool decodeInt64(const QByteArray &data, int rows, QVector<qint64> &values)
+{
+    if (data.size() != rows * static_cast<int>(sizeof(qint64))) {
+        return false;
+    }
+
+    values.resize(rows);
+    for (int i = 0; i < rows; i++) {
+        values[i] = qFromLittleEndian<qint64>(data.constData() + i * sizeof(qint64));
+    }
+    return true;
+}
+
+static bool decodeDouble(const QByteArray &data, int rows, QVector<double> &values)
+{
+    if (data.size() != rows * static_cast<int>(sizeof(double))) {
+        return false;
+    }
+
+    values.resize(rows);
+    for (int i = 0; i < rows; i++) {
+        quint64 bits = qFromLittleEndian<quint64>(data.constData() + i * sizeof(quint64));
+        std::memcpy(&values[i], &bits, sizeof(bits));
+    }
+    return true;
+}
+
+static bool decodeStrings(const QByteArray &data, int rows, QStringList &values)
+{
+    values.clear();
+    values.reserve(rows);
+
+    int position = 0;
+    for (int i = 0; i < rows; i++) {
+        if (position + 4 > data.size()) {
+            return false;
+        }
+        int length = static_cast<int>(qFromLittleEndian<quint32>(data.constData() + position));
+        position += 4;
+        if (length < 0 || position + length > data.size()) {
+            return false;
+        }
+        values.append(QString::fromUtf8(data.constData() + position, length));
+        position += length;
+    }
+    return true;
+}
+
+SalesSnapshot::SalesSnapshot(const QString &path)
+    : path(path)
+{
+}
+
+ProfitReport SalesSnapshot::generateProfitReport(const QDate &startDate, const QDate &endDate)
+{
+    ProfitReport report;
+    report.startDate = startDate;
+    report.endDate = endDate;
+    report.totalRevenue = 0;
+    report.totalCost = 0;
+    report.totalProfit = 0;
+
+    error.clear();
+
+    SnapshotReader reader;
+    if (!reader.open(path, error, created)) {
+        return report;
+    }
+
+    // Те же границы, что DATE(sale_date) BETWEEN в Database::generateProfitReport
+    const qint64 from = QDateTime(startDate, QTime(0, 0), Qt::UTC).toMSecsSinceEpoch();
+    const qint64 to = QDateTime(endDate.addDays(1), QTime(0, 0), Qt::UTC).toMSecsSinceEpoch();
+
+    QHash<qint64, QPair<QString, double>> products;
+    QSet<qint64> saleIds;
+    qint64 minSaleId = std::numeric_limits<qint64>::max();
+    qint64 maxSaleId = std::numeric_limits<qint64>::min();
+    QHash<qint64, qint64> soldQuantity;
+
+    QVector<SnapshotChunk> chunks;
+    QByteArray data;
+    QVector<qint64> ids;
+    QVector<qint64> keys;
+    QVector<qint64> quantities;
+    QVector<double> amounts;
+    QStringList names;
+
+    for (quint32 table = 0; table < reader.tableCount(); table++) {
+        QByteArray tableName;
+        QList<QByteArray> columns;
+        if (!reader.readTableHeader(tableName, columns)) {
+            error = "Поврежден заголовок таблицы в снимке";
+            return report;
+        }
+
+        QList<QByteArray> required;
+        if (tableName == "products") {
+            required = {"id", "name", "purchase_price"};
+        } else if (tableName == "sales") {
+            required = {"id", "sale_date"};
+        } else if (tableName == "sale_items") {
+            required = {"sale_id", "product_id", "quantity", "total_price"};
+        }
+
+        QList<int> index;
+        for (const QByteArray &column : required) {
+            index.append(columns.indexOf(column));
+            if (index.last() < 0) {
+                error = QString("В таблице %1 снимка нет колонки %2")
+                            .arg(QString::fromUtf8(tableName), QString::fromUtf8(column));
+                return report;
+            }
+        }
+
+        int rows;
+        while ((rows = reader.readBlock(chunks)) > 0) {
+            bool ok = true;
+
+            if (tableName == "products") {
+                ok = reader.readChunk(chunks[index[0]], data) && decodeInt64(data, rows, ids)
+                     && reader.readChunk(chunks[index[1]], data) && decodeStrings(data, rows, names)
+                     && reader.readChunk(chunks[index[2]], data) && decodeDouble(data, rows, amounts);
+
+                for (int i = 0; ok && i < rows; i++) {
+                    products.insert(ids[i], qMakePair(names[i], amounts[i]));
+                }
+            } else if (tableName == "sales") {
+                const SnapshotChunk &dates = chunks[index[1]];
+                if (!dates.hasStats || dates.maxInt < from || dates.minInt >= to) {
+                    continue;
+                }
+
+                ok = reader.readChunk(chunks[index[0]], data) && decodeInt64(data, rows, ids)
+                     && reader.readChunk(dates, data) && decodeInt64(data, rows, keys);
+
+                for (int i = 0; ok && i < rows; i++) {
+                    if (keys[i] != NULL_INT && keys[i] >= from && keys[i] < to) {
+                        saleIds.insert(ids[i]);
+                        minSaleId = qMin(minSaleId, ids[i]);
+                        maxSaleId = qMax(maxSaleId, ids[i]);
+                    }
+                }
+            } else if (tableName == "sale_items") {
+                const SnapshotChunk &sales = chunks[index[0]];
+                if (saleIds.isEmpty() || !sales.hasStats || sales.maxInt < minSaleId || sales.minInt > maxSaleId) {
+                    continue;
+                }
+
+                QVector<qint64> productIds;
+                ok = reader.readChunk(sales, data) && decodeInt64(data, rows, keys)
+                     && reader.readChunk(chunks[index[1]], data) && decodeInt64(data, rows, productIds)
+                     && reader.readChunk(chunks[index[2]], data) && decodeInt64(data, rows, quantities)
+                     && reader.readChunk(chunks[index[3]], data) && decodeDouble(data, rows, amounts);
+
+                for (int i = 0; ok && i < rows; i++) {
+                    if (!saleIds.contains(keys[i])) {
+                        continue;
+                    }
+
+                    auto product = products.constFind(productIds[i]);
+                    if (product == products.constEnd()) {
+                        continue;
+                    }
+
+                    if (!std::isnan(amounts[i])) {
+                        report.totalRevenue += amounts[i];
+                    }
+                    if (quantities[i] != NULL_INT) {
+                        report.totalCost += quantities[i] * product.value().second;
+                        soldQuantity[productIds[i]] += quantities[i];
+                    }
+                }
+            }
+
+            if (!ok) {
+                error = "Поврежден блок данных в снимке";
+                return report;
+            }
+        }
+
+        if (rows < 0) {
+            error = "Снимок поврежден или обрезан";
+            return report;
+        }
+    }
+
+    report.totalProfit = report.totalRevenue - report.totalCost;
+
+    QList<QPair<qint64, qint64>> popular;
+    for (auto it = soldQuantity.constBegin(); it != soldQuantity.constEnd(); ++it) {
+        popular.append(qMakePair(it.value(), it.key()));
+    }
+    std::sort(popular.begin(), popular.end(), [](const QPair<qint64, qint64> &a, const QPair<qint64, qint64> &b) {
+        return a.first > b.first;
+    });
+
+    for (int i = 0; i < popular.size() && i < 10; i++) {
+        report.popularProducts.append(
+            qMakePair(products.value(popular[i].second).first, static_cast<int>(popular[i].first)));
+    }
+
+    return report;
+}
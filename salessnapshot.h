@@ -0,0 +1,48 @@
+#ifndef SALESSNAPSHOT_H
+#define SALESSNAPSHOT_H
+
+#include <QDateTime>
+#include <QString>
+#include "database.h"
+
+// Колоночный снимок продаж для аналитики (*.hgsnap).
+//
+// Все числа little-endian, строки UTF-8.
+//
+//   Файл:    "HGSSNAP1" (8 байт), quint32 версия формата (1),
+//            qint64 время создания (мс от эпохи, UTC), quint32 число таблиц,
+//            затем таблицы products, sales, sale_items.
+//   Таблица: quint32 длина + имя, quint32 число колонок,
+//            для каждой колонки quint32 длина + имя и quint8 тип,
+//            затем блоки; блок с числом строк 0 завершает таблицу.
+//   Блок:    quint32 число строк (до 65536), затем по фрагменту на колонку.
+//   Фрагмент: quint8 сжатие (0 - нет, 1 - zlib в формате qCompress),
+//            quint8 есть ли min/max; для числовых колонок всегда два значения
+//            min и max (qint64 или double), для строковых - ничего;
+//            quint64 размер данных, затем данные.
+//   Типы:    1 - int64, 2 - double, 3 - строка (quint32 длина + байты),
+//            4 - время (int64, мс от эпохи, время как записано в базе, UTC).
+//   NULL:    для int64 и времени - минимальное значение int64, для double - NaN;
+//            в min/max не учитывается.
+//
+// По min/max блоков отчет пропускает блоки вне периода, не читая их данные.
+class SalesSnapshot
+{
+public:
+    explicit SalesSnapshot(const QString &path);
+
+    static bool write(Database &db, const QString &path, bool compress, QString &error);
+
+    ProfitReport generateProfitReport(const QDate &startDate, const QDate &endDate);
+
+    bool hasError() const { return !error.isEmpty(); }
+    QString errorString() const { return error; }
+    QDateTime createdAt() const { return created; }
+
+private:
+    QString path;
+    QString error;
+    QDateTime created;
+};
+
+#endif // SALESSNAPSHOT_H
@@ -21,12 +21,22 @@ CREATE TABLE IF NOT EXISTS products (
     category_id INTEGER,
     purchase_price REAL NOT NULL CHECK (purchase_price >= 0),
     retail_price REAL NOT NULL CHECK (retail_price >= 0),
-    stock INTEGER NOT NULL DEFAULT 0 CHECK (stock >= 0),
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
     updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    version INTEGER NOT NULL DEFAULT 1,
     FOREIGN KEY (category_id) REFERENCES product_categories(id) ON DELETE SET NULL
 );
 
+CREATE TABLE IF NOT EXISTS supply_documents (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    document_number TEXT UNIQUE NOT NULL,
+    supplier_name TEXT NOT NULL,
+    supply_date TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    created_by INTEGER NOT NULL,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    FOREIGN KEY (created_by) REFERENCES users(id)
+);
+
 CREATE TABLE IF NOT EXISTS supplies (
     id INTEGER PRIMARY KEY AUTOINCREMENT,
     supply_number TEXT UNIQUE NOT NULL,
@@ -38,8 +48,10 @@ CREATE TABLE IF NOT EXISTS supplies (
     supply_date TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
     created_by INTEGER NOT NULL,
     created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    document_id INTEGER,
     FOREIGN KEY (product_id) REFERENCES products(id),
-    FOREIGN KEY (created_by) REFERENCES users(id)
+    FOREIGN KEY (created_by) REFERENCES users(id),
+    FOREIGN KEY (document_id) REFERENCES supply_documents(id)
 );
 
 CREATE TABLE IF NOT EXISTS sales (
@@ -67,6 +79,30 @@ CREATE TABLE IF NOT EXISTS sale_items (
     FOREIGN KEY (product_id) REFERENCES products(id)
 );
 
+CREATE TABLE IF NOT EXISTS stock_movements (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    product_id INTEGER NOT NULL,
+    quantity INTEGER NOT NULL CHECK (quantity <> 0),
+    reason TEXT NOT NULL CHECK (reason IN ('initial', 'supply', 'sale', 'cart_reserve',
+                                           'cart_release', 'adjustment', 'reconcile')),
+    reference_id INTEGER,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    FOREIGN KEY (product_id) REFERENCES products(id) ON DELETE CASCADE
+);
+
+CREATE TABLE IF NOT EXISTS stock_snapshots (
+    product_id INTEGER PRIMARY KEY,
+    stock INTEGER NOT NULL,
+    movement_id INTEGER NOT NULL,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    FOREIGN KEY (product_id) REFERENCES products(id) ON DELETE CASCADE
+);
+
+CREATE TABLE IF NOT EXISTS archived_sale_totals (
+    product_id INTEGER PRIMARY KEY,
+    quantity INTEGER NOT NULL DEFAULT 0
+);
+
 CREATE TABLE IF NOT EXISTS cart_items (
     id INTEGER PRIMARY KEY AUTOINCREMENT,
     user_id INTEGER NOT NULL,
@@ -78,14 +114,54 @@ CREATE TABLE IF NOT EXISTS cart_items (
     UNIQUE(user_id, product_id)
 );
 
+CREATE TABLE IF NOT EXISTS promotions (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    name TEXT NOT NULL,
+    kind TEXT NOT NULL CHECK (kind IN ('quantity', 'category', 'bundle')),
+    percent REAL NOT NULL CHECK (percent > 0 AND percent <= 100),
+    min_quantity INTEGER NOT NULL DEFAULT 1,
+    category_id INTEGER,
+    product_id INTEGER,
+    bundle_product_id INTEGER,
+    valid_from TIMESTAMP,
+    valid_to TIMESTAMP,
+    hour_from INTEGER CHECK (hour_from BETWEEN 0 AND 23),
+    hour_to INTEGER CHECK (hour_to BETWEEN 0 AND 24),
+    active INTEGER NOT NULL DEFAULT 1,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    FOREIGN KEY (category_id) REFERENCES product_categories(id) ON DELETE CASCADE,
+    FOREIGN KEY (product_id) REFERENCES products(id) ON DELETE CASCADE,
+    FOREIGN KEY (bundle_product_id) REFERENCES products(id) ON DELETE CASCADE
+);
+
+CREATE TABLE IF NOT EXISTS price_lists (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    name TEXT NOT NULL,
+    valid_from TIMESTAMP NOT NULL,
+    valid_to TIMESTAMP,
+    created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+    CHECK (valid_to IS NULL OR valid_to > valid_from)
+);
+
+CREATE TABLE IF NOT EXISTS price_list_items (
+    price_list_id INTEGER NOT NULL,
+    product_id INTEGER NOT NULL,
+    retail_price REAL NOT NULL CHECK (retail_price >= 0),
+    PRIMARY KEY (price_list_id, product_id),
+    FOREIGN KEY (price_list_id) REFERENCES price_lists(id) ON DELETE CASCADE,
+    FOREIGN KEY (product_id) REFERENCES products(id) ON DELETE CASCADE
+);
+
 CREATE INDEX IF NOT EXISTS idx_products_article ON products(article);
 CREATE INDEX IF NOT EXISTS idx_products_category ON products(category_id);
-CREATE INDEX IF NOT EXISTS idx_products_stock ON products(stock);
+CREATE INDEX IF NOT EXISTS idx_products_name_nocase ON products(name COLLATE NOCASE);
+CREATE INDEX IF NOT EXISTS idx_products_article_nocase ON products(article COLLATE NOCASE);
 
 CREATE INDEX IF NOT EXISTS idx_supplies_date ON supplies(supply_date);
 CREATE INDEX IF NOT EXISTS idx_supplies_supplier ON supplies(supplier_name);
-CREATE INDEX IF NOT EXISTS idx_supplies_product ON supplies(product_id);
+CREATE INDEX IF NOT EXISTS idx_supplies_product ON supplies(product_id, quantity);
 CREATE INDEX IF NOT EXISTS idx_supplies_created_by ON supplies(created_by);
+CREATE INDEX IF NOT EXISTS idx_supplies_document ON supplies(document_id);
 
 CREATE INDEX IF NOT EXISTS idx_sales_date ON sales(sale_date);
 CREATE INDEX IF NOT EXISTS idx_sales_cashier ON sales(cashier_id);
@@ -93,11 +169,27 @@ CREATE INDEX IF NOT EXISTS idx_sales_customer ON sales(customer_id);
 CREATE INDEX IF NOT EXISTS idx_sales_receipt_number ON sales(receipt_number);
 
 CREATE INDEX IF NOT EXISTS idx_sale_items_sale ON sale_items(sale_id);
-CREATE INDEX IF NOT EXISTS idx_sale_items_product ON sale_items(product_id);
+CREATE INDEX IF NOT EXISTS idx_sale_items_product ON sale_items(product_id, quantity);
+
+CREATE INDEX IF NOT EXISTS idx_price_lists_valid_to ON price_lists(valid_to);
 
 CREATE INDEX IF NOT EXISTS idx_cart_items_user ON cart_items(user_id);
 CREATE INDEX IF NOT EXISTS idx_cart_items_product ON cart_items(product_id);
 
+CREATE INDEX IF NOT EXISTS idx_stock_movements_product ON stock_movements(product_id, id);
+CREATE INDEX IF NOT EXISTS idx_stock_movements_manual ON stock_movements(product_id, quantity)
+    WHERE reason IN ('initial', 'adjustment', 'reconcile');
+
+CREATE VIEW IF NOT EXISTS product_stock AS
+SELECT p.id AS product_id,
+       COALESCE(s.stock, 0) + COALESCE((
+           SELECT SUM(m.quantity)
+           FROM stock_movements m
+           WHERE m.product_id = p.id AND m.id > COALESCE(s.movement_id, 0)
+       ), 0) AS stock
+FROM products p
+LEFT JOIN stock_snapshots s ON s.product_id = p.id;
+
 INSERT OR IGNORE INTO users (login, password, role) VALUES
 ('admin', 'admin123', 'Администратор'),
 ('cashier1', 'cashier123', 'Кассир'),
@@ -109,19 +201,29 @@ INSERT OR IGNORE INTO product_categories (name) VALUES
 ('Продукты питания'),
 ('Одежда');
 
+INSERT INTO promotions (name, kind, percent, min_quantity)
+SELECT 'От 3 товаров', 'quantity', 5, 3
+WHERE NOT EXISTS (SELECT 1 FROM promotions);
+
+INSERT INTO promotions (name, kind, percent, min_quantity)
+SELECT 'От 6 товаров', 'quantity', 10, 6
+WHERE NOT EXISTS (SELECT 1 FROM promotions WHERE min_quantity = 6 AND kind = 'quantity');
+
 CREATE TRIGGER IF NOT EXISTS calculate_supply_total_amount
 AFTER INSERT ON supplies
+WHEN NEW.total_amount IS NULL
 BEGIN
     UPDATE supplies
-    SET total_amount = NEW.quantity * NEW.purchase_price
+    SET total_amount = ROUND(NEW.quantity * NEW.purchase_price, 2)
     WHERE id = NEW.id;
 END;
 
 CREATE TRIGGER IF NOT EXISTS calculate_sale_final_amount
 AFTER INSERT ON sales
+WHEN NEW.final_amount IS NULL
 BEGIN
     UPDATE sales
-    SET final_amount = NEW.total_amount * (1 - COALESCE(NEW.discount_amount, 0) / 100.0)
+    SET final_amount = NEW.total_amount - ROUND(NEW.total_amount * COALESCE(NEW.discount_amount, 0) / 100.0, 2)
     WHERE id = NEW.id;
 END;
 
@@ -130,43 +232,19 @@ AFTER INSERT ON sale_items
 WHEN NEW.total_price IS NULL
 BEGIN
     UPDATE sale_items
-    SET total_price = NEW.quantity * NEW.retail_price
+    SET total_price = ROUND(NEW.quantity * NEW.retail_price, 2)
     WHERE id = NEW.id;
 END;
 
-CREATE TRIGGER IF NOT EXISTS update_stock_on_supply
-AFTER INSERT ON supplies
-BEGIN
-    UPDATE products
-    SET stock = stock + NEW.quantity,
-        updated_at = CURRENT_TIMESTAMP
-    WHERE id = NEW.product_id;
-END;
-
-CREATE TRIGGER IF NOT EXISTS update_stock_on_sale
-BEFORE INSERT ON sale_items
-FOR EACH ROW
-BEGIN
-    SELECT CASE
-        WHEN (SELECT stock FROM products WHERE id = NEW.product_id) < NEW.quantity
-        THEN RAISE(ABORT, 'Недостаточно товара на складе')
-    END;
-
-    UPDATE products
-    SET stock = stock - NEW.quantity,
-        updated_at = CURRENT_TIMESTAMP
-    WHERE id = NEW.product_id;
-END;
-
 CREATE TRIGGER IF NOT EXISTS update_sale_total_amount
 AFTER INSERT ON sale_items
 BEGIN
     UPDATE sales
-    SET total_amount = (
+    SET total_amount = ROUND((
         SELECT COALESCE(SUM(total_price), 0)
         FROM sale_items
         WHERE sale_id = NEW.sale_id
-    )
+    ), 2)
     WHERE id = NEW.sale_id;
 END;
 
@@ -174,40 +252,68 @@ CREATE TRIGGER IF NOT EXISTS update_sale_total_amount_on_delete
 AFTER DELETE ON sale_items
 BEGIN
     UPDATE sales
-    SET total_amount = (
+    SET total_amount = ROUND((
         SELECT COALESCE(SUM(total_price), 0)
         FROM sale_items
         WHERE sale_id = OLD.sale_id
-    )
+    ), 2)
     WHERE id = OLD.sale_id;
 END;
 
-CREATE TRIGGER IF NOT EXISTS decrease_stock_on_cart_insert
+CREATE TRIGGER IF NOT EXISTS check_stock_on_movement
+BEFORE INSERT ON stock_movements
+FOR EACH ROW
+WHEN NEW.quantity < 0 AND NEW.reason <> 'reconcile'
+BEGIN
+    SELECT CASE
+        WHEN (SELECT stock FROM product_stock WHERE product_id = NEW.product_id) + NEW.quantity < 0
+        THEN RAISE(ABORT, 'Недостаточно товара на складе')
+    END;
+END;
+
+-- Строки документа поставки проводятся одним INSERT ... SELECT в addSupplyDocument
+CREATE TRIGGER IF NOT EXISTS record_supply_movement
+AFTER INSERT ON supplies
+FOR EACH ROW
+WHEN NEW.document_id IS NULL
+BEGIN
+    INSERT INTO stock_movements (product_id, quantity, reason, reference_id)
+    VALUES (NEW.product_id, NEW.quantity, 'supply', NEW.id);
+END;
+
+CREATE TRIGGER IF NOT EXISTS record_sale_movement
+AFTER INSERT ON sale_items
+FOR EACH ROW
+BEGIN
+    INSERT INTO stock_movements (product_id, quantity, reason, reference_id)
+    VALUES (NEW.product_id, -NEW.quantity, 'sale', NEW.sale_id);
+END;
+
+CREATE TRIGGER IF NOT EXISTS record_cart_insert_movement
 AFTER INSERT ON cart_items
 FOR EACH ROW
 BEGIN
-    UPDATE products
-    SET stock = stock - NEW.quantity,
-        updated_at = CURRENT_TIMESTAMP
-    WHERE id = NEW.product_id;
+    INSERT INTO stock_movements (product_id, quantity, reason, reference_id)
+    VALUES (NEW.product_id, -NEW.quantity, 'cart_reserve', NEW.user_id);
 END;
 
-CREATE TRIGGER IF NOT EXISTS update_stock_on_cart_update
+CREATE TRIGGER IF NOT EXISTS record_cart_update_movement
 AFTER UPDATE OF quantity ON cart_items
 FOR EACH ROW
+WHEN NEW.quantity <> OLD.quantity
 BEGIN
-    UPDATE products
-    SET stock = stock - (NEW.quantity - OLD.quantity),
-        updated_at = CURRENT_TIMESTAMP
-    WHERE id = NEW.product_id;
+    INSERT INTO stock_movements (product_id, quantity, reason, reference_id)
+    VALUES (NEW.product_id, OLD.quantity - NEW.quantity,
+            CASE WHEN NEW.quantity > OLD.quantity THEN 'cart_reserve' ELSE 'cart_release' END,
+            NEW.user_id);
 END;
 
-CREATE TRIGGER IF NOT EXISTS increase_stock_on_cart_delete
+CREATE TRIGGER IF NOT EXISTS record_cart_delete_movement
 AFTER DELETE ON cart_items
 FOR EACH ROW
 BEGIN
-    UPDATE products
-    SET stock = stock + OLD.quantity,
-        updated_at = CURRENT_TIMESTAMP
-    WHERE id = OLD.product_id;
-END;
\ No newline at end of file
+    INSERT INTO stock_movements (product_id, quantity, reason, reference_id)
+    VALUES (OLD.product_id, OLD.quantity, 'cart_release', OLD.user_id);
+END;
+
+PRAGMA user_version = 10;
@@ -0,0 +1,143 @@
+#include "stockreconciler.h"
+#include "database.h"
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+// Диапазонов больше, чем потоков, чтобы потоки не простаивали на неравных диапазонах
+static const int RANGES_PER_THREAD = 4;
+
+// Снимок остатка товара переписывается, только если хвост журнала стал длиннее
+static const int SNAPSHOT_MIN_TAIL = 100;
+
+static QAtomicInt readerCounter;
+
+struct RangeResult {
+    bool ok = false;
+    int checked = 0;
+    QList<StockMismatch> mismatches;
+};
+
+static RangeResult checkRange(const QString &dbPath, int firstId, int lastId)
+{
+    RangeResult result;
+    QString connectionName = QString("reconcile_%1").arg(readerCounter.fetchAndAddRelaxed(1));
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        db.setDatabaseName(dbPath);
+        db.setConnectOptions("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000");
+
+        if (!db.open()) {
+            qDebug() << "Сверка: не удалось открыть базу:" << db.lastError().text();
+        } else {
+            // Одна читающая транзакция на диапазон: журнал и исходные таблицы
+            // видны в одном и том же состоянии
+            QSqlQuery query(db);
+            query.exec("BEGIN");
+
+            query.prepare(Database::stockCheckQueryText());
+            query.bindValue(":first_id", firstId);
+            query.bindValue(":last_id", lastId);
+
+            if (query.exec()) {
+                while (query.next()) {
+                    result.checked++;
+
+                    int ledgerStock = query.value(2).toInt();
+                    int expectedStock = query.value(3).toInt();
+                    if (ledgerStock != expectedStock) {
+                        result.mismatches.append({query.value(0).toInt(), query.value(1).toString(),
+                                                  ledgerStock, expectedStock});
+                    }
+                }
+                result.ok = true;
+            } else {
+                qDebug() << "Сверка: ошибка SQL:" << query.lastError().text();
+            }
+
+            query.finish();
+            query.exec("COMMIT");
+            db.close();
+        }
+    }
+
+    QSqlDatabase::removeDatabase(connectionName);
+    return result;
+}
+
+StockReconciler::StockReconciler(const QString &dbPath, int threadCount)
+    : dbPath(dbPath)
+    , threadCount(threadCount)
+{
+}
+
+ReconciliationReport StockReconciler::run(bool repair)
+{
+    ReconciliationReport report;
+    report.ok = false;
+    report.productsChecked = 0;
+    report.repaired = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    Database db;
+    if (!db.connectToDatabase(dbPath)) {
+        report.elapsedMs = timer.elapsed();
+        return report;
+    }
+
+    int minId = 0;
+    int maxId = -1;
+    if (!db.getProductIdRange(minId, maxId)) {
+        report.elapsedMs = timer.elapsed();
+        return report;
+    }
+
+    QThreadPool pool;
+    if (threadCount > 0) {
+        pool.setMaxThreadCount(threadCount);
+    }
+
+    QList<QFuture<RangeResult>> futures;
+    if (maxId >= minId) {
+        qint64 span = static_cast<qint64>(maxId) - minId + 1;
+        int rangeCount = static_cast<int>(qMin<qint64>(span, pool.maxThreadCount() * RANGES_PER_THREAD));
+        qint64 rangeSize = (span + rangeCount - 1) / rangeCount;
+
+        for (qint64 first = minId; first <= maxId; first += rangeSize) {
+            int firstId = static_cast<int>(first);
+            int lastId = static_cast<int>(qMin<qint64>(first + rangeSize - 1, maxId));
+            futures.append(QtConcurrent::run(&pool, checkRange, dbPath, firstId, lastId));
+        }
+    }
+
+    report.ok = true;
+    for (QFuture<RangeResult> &future : futures) {
+        RangeResult range = future.result();
+        report.ok = report.ok && range.ok;
+        report.productsChecked += range.checked;
+        report.mismatches += range.mismatches;
+    }
+
+    if (report.ok && repair && !report.mismatches.isEmpty()) {
+        QList<int> productIds;
+        for (const StockMismatch &mismatch : report.mismatches) {
+            productIds.append(mismatch.productId);
+        }
+
+        report.repaired = db.reconcileStock(productIds);
+        report.ok = report.repaired >= 0;
+    }
+
+    // Сверка - плановое обслуживание: заодно сокращаем длинные хвосты журнала остатков
+    if (report.ok) {
+        db.createStockSnapshots(SNAPSHOT_MIN_TAIL);
+    }
+
+    report.elapsedMs = timer.elapsed();
+    return report;
+}
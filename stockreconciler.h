@@ -0,0 +1,37 @@
+#ifndef STOCKRECONCILER_H
+#define STOCKRECONCILER_H
+
+#include <QList>
+#include <QString>
+
+struct StockMismatch {
+    int productId;
+    QString productName;
+    int ledgerStock;
+    int expectedStock;
+};
+
+struct ReconciliationReport {
+    bool ok;
+    int productsChecked;
+    QList<StockMismatch> mismatches;
+    int repaired;
+    qint64 elapsedMs;
+};
+
+// Сверка остатков: журнал движений сравнивается с остатком, пересчитанным
+// из поставок, продаж и корзин. Товары делятся на диапазоны id, каждый
+// диапазон проверяется в отдельном потоке на своем соединении только для чтения.
+class StockReconciler
+{
+public:
+    explicit StockReconciler(const QString &dbPath = "shop.db", int threadCount = 0);
+
+    ReconciliationReport run(bool repair = false);
+
+private:
+    QString dbPath;
+    int threadCount;
+};
+
+#endif // STOCKRECONCILER_H
@@ -0,0 +1,548 @@
+#include "storeservice.h"
+#include "stockreconciler.h"
+#include "promotionengine.h"
+#include "priceindex.h"
+#include "categorycache.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadStorage>
+
+static QThreadStorage<Database *> threadDatabases;
+
+// Как часто фиксировать снимок остатков, чтобы хвост журнала движений оставался коротким
+static const int SNAPSHOT_INTERVAL_MS = 10 * 60 * 1000;
+static const int SNAPSHOT_MIN_TAIL = 100;
+
+// Сессия без запросов дольше этого считается закрытой
+static const int SESSION_IDLE_SECS = 8 * 60 * 60;
+
+static const char *const ROLE_ADMIN = "Администратор";
+static const char *const ROLE_CASHIER = "Кассир";
+
+// Методы, доступные только администратору
+static bool requiresAdministrator(const QString &method)
+{
+    static const QSet<QString> methods = {
+        "catalog.all", "stock.history", "stock.reconcile", "sales.archive", "reports.profit"
+    };
+    return methods.contains(method);
+}
+
+static QJsonObject userToJson(const User &user)
+{
+    QJsonObject json;
+    json["id"] = user.id;
+    json["login"] = user.login;
+    json["role"] = user.role;
+    return json;
+}
+
+static QJsonObject productToJson(const Product &product)
+{
+    QJsonObject json;
+    json["id"] = product.id;
+    json["article"] = product.article;
+    json["name"] = product.name;
+    json["categoryId"] = product.categoryId;
+    json["categoryName"] = product.categoryName;
+    json["purchasePrice"] = product.purchasePrice;
+    json["retailPrice"] = product.retailPrice;
+    json["stock"] = product.stock;
+    return json;
+}
+
+static QJsonObject saleToJson(const Sale &sale)
+{
+    QJsonObject json;
+    json["id"] = sale.id;
+    json["receiptNumber"] = sale.receiptNumber;
+    json["saleDate"] = sale.saleDate.toString(Qt::ISODate);
+    json["cashierId"] = sale.cashierId;
+    json["cashierName"] = sale.cashierName;
+    json["customerId"] = sale.customerId;
+    json["customerName"] = sale.customerName;
+    json["totalAmount"] = sale.totalAmount;
+    json["discountAmount"] = sale.discountAmount;
+    json["finalAmount"] = sale.finalAmount;
+    return json;
+}
+
+static QJsonObject saleItemToJson(const SaleItem &item)
+{
+    QJsonObject json;
+    json["productId"] = item.productId;
+    json["productName"] = item.productName;
+    json["quantity"] = item.quantity;
+    json["retailPrice"] = item.retailPrice;
+    json["totalPrice"] = item.totalPrice;
+    return json;
+}
+
+static QJsonObject stockMovementToJson(const StockMovement &movement)
+{
+    QJsonObject json;
+    json["id"] = movement.id;
+    json["productId"] = movement.productId;
+    json["quantity"] = movement.quantity;
+    json["reason"] = movement.reason;
+    json["referenceId"] = movement.referenceId;
+    json["createdAt"] = movement.createdAt.toString(Qt::ISODate);
+    return json;
+}
+
+static QJsonObject cartItemToJson(const CartItem &item)
+{
+    QJsonObject json;
+    json["productId"] = item.productId;
+    json["productName"] = item.productName;
+    json["retailPrice"] = item.retailPrice;
+    json["quantity"] = item.quantity;
+    json["addedAt"] = item.addedAt.toString(Qt::ISODate);
+    return json;
+}
+
+template <typename T>
+static QJsonArray listToJson(const QList<T> &list, QJsonObject (*convert)(const T &))
+{
+    QJsonArray array;
+    for (const T &value : list) {
+        array.append(convert(value));
+    }
+    return array;
+}
+
+static QJsonObject resultResponse(const QJsonValue &result)
+{
+    QJsonObject response;
+    response["result"] = result;
+    return response;
+}
+
+static QJsonObject errorResponse(const QString &message)
+{
+    QJsonObject response;
+    response["error"] = message;
+    return response;
+}
+
+StoreService::StoreService(const QString &dbPath, int threadCount, QObject *parent)
+    : QObject(parent)
+    , server(new QLocalServer(this))
+    , dbPath(dbPath)
+{
+    if (threadCount > 0) {
+        pool.setMaxThreadCount(threadCount);
+    }
+
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(server, &QLocalServer::newConnection, this, &StoreService::onNewConnection);
+
+    connect(&snapshotTimer, &QTimer::timeout, this, &StoreService::onSnapshotTimer);
+    snapshotTimer.start(SNAPSHOT_INTERVAL_MS);
+}
+
+StoreService::~StoreService()
+{
+    snapshotTimer.stop();
+    server->close();
+    pool.waitForDone();
+}
+
+bool StoreService::listen(const QString &name)
+{
+    QLocalServer::removeServer(name);
+
+    if (!server->listen(name)) {
+        qWarning() << "Не удалось открыть сокет" << name << ":" << server->errorString();
+        return false;
+    }
+
+    qDebug() << "Service listening on" << server->fullServerName()
+             << "with" << pool.maxThreadCount() << "worker threads";
+    return true;
+}
+
+void StoreService::onNewConnection()
+{
+    while (QLocalSocket *socket = server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead, this, &StoreService::onReadyRead);
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+    }
+}
+
+void StoreService::onReadyRead()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if (!socket) return;
+
+    while (socket->canReadLine()) {
+        QByteArray line = socket->readLine().trimmed();
+        if (!line.isEmpty()) {
+            dispatch(socket, line);
+        }
+    }
+}
+
+void StoreService::onSnapshotTimer()
+{
+    pool.start(QRunnable::create([this]() {
+        Database *db = threadDatabase();
+        if (!db || !db->createStockSnapshots(SNAPSHOT_MIN_TAIL)) {
+            qWarning() << "Не удалось сохранить снимок остатков";
+        }
+    }));
+}
+
+void StoreService::dispatch(QLocalSocket *socket, const QByteArray &line)
+{
+    QPointer<QLocalSocket> target(socket);
+
+    pool.start(QRunnable::create([this, target, line]() {
+        QJsonParseError parseError;
+        QJsonDocument request = QJsonDocument::fromJson(line, &parseError);
+
+        QJsonObject response;
+        if (parseError.error != QJsonParseError::NoError || !request.isObject()) {
+            response = errorResponse("Некорректный JSON: " + parseError.errorString());
+        } else {
+            QJsonObject object = request.object();
+            response = handleRequest(object.value("method").toString(),
+                                     object.value("params").toObject());
+            response["id"] = object.value("id");
+        }
+
+        QByteArray payload = QJsonDocument(response).toJson(QJsonDocument::Compact) + '\n';
+
+        QMetaObject::invokeMethod(this, [target, payload]() {
+            if (target) {
+                target->write(payload);
+            }
+        }, Qt::QueuedConnection);
+    }));
+}
+
+Database *StoreService::threadDatabase()
+{
+    if (!threadDatabases.hasLocalData()) {
+        Database *db = new Database();
+        if (!db->connectToDatabase(dbPath)) {
+            delete db;
+            return nullptr;
+        }
+        threadDatabases.setLocalData(db);
+    }
+
+    return threadDatabases.localData();
+}
+
+QString StoreService::openSession(const User &user)
+{
+    quint32 random[8];
+    QRandomGenerator::system()->fillRange(random);
+    QString token = QString::fromLatin1(QByteArray(reinterpret_cast<const char *>(random), sizeof(random)).toHex());
+
+    Session session;
+    session.user = user;
+    session.user.password.clear();
+    session.lastSeen = QDateTime::currentDateTimeUtc();
+
+    QMutexLocker locker(&sessionMutex);
+
+    // Заодно убираем брошенные сессии, чтобы таблица не росла
+    QDateTime expired = session.lastSeen.addSecs(-SESSION_IDLE_SECS);
+    for (auto it = sessions.begin(); it != sessions.end();) {
+        if (it->lastSeen < expired) {
+            it = sessions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    sessions.insert(token, session);
+    return token;
+}
+
+User StoreService::sessionUser(const QString &token)
+{
+    User none;
+    none.id = -1;
+
+    if (token.isEmpty()) {
+        return none;
+    }
+
+    QMutexLocker locker(&sessionMutex);
+
+    auto it = sessions.find(token);
+    if (it == sessions.end()) {
+        return none;
+    }
+
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    if (it->lastSeen.secsTo(now) > SESSION_IDLE_SECS) {
+        sessions.erase(it);
+        return none;
+    }
+
+    it->lastSeen = now;
+    return it->user;
+}
+
+void StoreService::closeSession(const QString &token)
+{
+    QMutexLocker locker(&sessionMutex);
+    sessions.remove(token);
+}
+
+QJsonObject StoreService::handleRequest(const QString &method, const QJsonObject &params)
+{
+    Database *db = threadDatabase();
+    if (!db) {
+        return errorResponse("Не удалось подключиться к базе данных");
+    }
+
+    if (method == "auth.login") {
+        User user = db->authenticateUser(params.value("login").toString(),
+                                         params.value("password").toString());
+        if (user.id == -1) {
+            return errorResponse("Неверное имя пользователя или пароль");
+        }
+
+        QJsonObject json = userToJson(user);
+        json["token"] = openSession(user);
+        return resultResponse(json);
+    }
+
+    const QString token = params.value("token").toString();
+    const User session = sessionUser(token);
+    if (session.id == -1) {
+        return errorResponse("Требуется вход: сессия не найдена или истекла");
+    }
+
+    if (requiresAdministrator(method) && session.role != ROLE_ADMIN) {
+        return errorResponse("Недостаточно прав");
+    }
+
+    if (method == "auth.logout") {
+        closeSession(token);
+        return resultResponse(true);
+    }
+
+    if (method == "catalog.list") {
+        QList<Product> products = db->getProductsForClient();
+        CategoryCache::instance().resolve(*db, products);
+        return resultResponse(listToJson(products, productToJson));
+    }
+
+    if (method == "catalog.all") {
+        QList<Product> products = db->getAllProducts();
+        CategoryCache::instance().resolve(*db, products);
+        return resultResponse(listToJson(products, productToJson));
+    }
+
+    if (method == "catalog.get") {
+        Product product = db->getProductById(params.value("productId").toInt());
+        if (product.id == -1) {
+            return errorResponse("Товар не найден");
+        }
+        product.categoryName = CategoryCache::instance().name(*db, product.categoryId);
+        return resultResponse(productToJson(product));
+    }
+
+    if (method == "stock.history") {
+        return resultResponse(listToJson(db->getStockMovements(params.value("productId").toInt()),
+                                         stockMovementToJson));
+    }
+
+    if (method == "stock.reconcile") {
+        ReconciliationReport report = StockReconciler(dbPath).run(params.value("repair").toBool());
+        if (!report.ok) {
+            return errorResponse("Не удалось выполнить сверку остатков");
+        }
+
+        QJsonArray mismatches;
+        for (const StockMismatch &mismatch : report.mismatches) {
+            QJsonObject item;
+            item["productId"] = mismatch.productId;
+            item["productName"] = mismatch.productName;
+            item["ledgerStock"] = mismatch.ledgerStock;
+            item["expectedStock"] = mismatch.expectedStock;
+            mismatches.append(item);
+        }
+
+        QJsonObject json;
+        json["productsChecked"] = report.productsChecked;
+        json["mismatches"] = mismatches;
+        json["repaired"] = report.repaired;
+        json["elapsedMs"] = report.elapsedMs;
+        return resultResponse(json);
+    }
+
+    if (method == "cart.list") {
+        return resultResponse(listToJson(db->getCartItems(session.id), cartItemToJson));
+    }
+
+    if (method == "cart.add") {
+        bool ok = db->addToCart(session.id,
+                                params.value("productId").toInt(),
+                                params.value("quantity").toInt(1));
+        return ok ? resultResponse(true) : errorResponse("Не удалось добавить товар в корзину");
+    }
+
+    if (method == "cart.update") {
+        bool ok = db->updateCartItemQuantity(session.id,
+                                             params.value("productId").toInt(),
+                                             params.value("quantity").toInt());
+        return ok ? resultResponse(true) : errorResponse("Не удалось изменить количество");
+    }
+
+    if (method == "cart.remove") {
+        bool ok = db->removeFromCart(session.id,
+                                     params.value("productId").toInt());
+        return ok ? resultResponse(true) : errorResponse("Не удалось удалить товар из корзины");
+    }
+
+    if (method == "cart.clear") {
+        bool ok = db->clearCart(session.id);
+        return ok ? resultResponse(true) : errorResponse("Не удалось очистить корзину");
+    }
+
+    if (method == "checkout.client") {
+        Sale sale;
+        sale.customerId = session.id;
+        sale.discountAmount = 0;
+
+        if (!db->createSaleForClient(sale)) {
+            return errorResponse("Не удалось оформить покупку");
+        }
+        return resultResponse(saleToJson(db->getSaleDetails(sale.id)));
+    }
+
+    if (method == "checkout.cashier") {
+        if (session.role != ROLE_CASHIER) {
+            return errorResponse("Недостаточно прав");
+        }
+
+        QList<SaleItem> items;
+        QVector<BasketLine> basket;
+
+        const QJsonArray itemsJson = params.value("items").toArray();
+        for (const QJsonValue &value : itemsJson) {
+            QJsonObject itemJson = value.toObject();
+
+            SaleItem item;
+            item.productId = itemJson.value("productId").toInt();
+            item.quantity = itemJson.value("quantity").toInt(1);
+
+            Product product = db->getProductById(item.productId);
+            if (product.id == -1) {
+                return errorResponse(QString("Товар не найден: %1").arg(item.productId));
+            }
+
+            // Цена всегда из прайса, присланная клиентом не принимается
+            Money price = PriceIndex::instance().price(*db, product.id, product.retailPrice);
+            item.retailPrice = price.toDouble();
+            item.totalPrice = (price * item.quantity).toDouble();
+            items.append(item);
+
+            basket.append({product.id, product.categoryId, price, item.quantity});
+        }
+
+        if (items.isEmpty()) {
+            return errorResponse("Корзина пуста");
+        }
+
+        PromotionResult totals = PromotionEngine::load(*db).evaluate(basket);
+        totals.addManualDiscount(qBound(0.0, params.value("discount").toDouble(0), 100.0));
+
+        Sale sale;
+        sale.cashierId = session.id;
+        sale.customerId = params.value("customerId").toInt(-1);
+        sale.totalAmount = totals.subtotal.toDouble();
+        sale.discountAmount = totals.percent();
+        sale.finalAmount = totals.total.toDouble();
+
+        if (db->createSale(sale, items) == -1) {
+            return errorResponse("Не удалось сохранить продажу");
+        }
+        return resultResponse(saleToJson(sale));
+    }
+
+    if (method == "sales.list") {
+        // Кассир видит только свои продажи, администратор - все или выбранного кассира
+        QList<Sale> sales;
+        if (session.role == ROLE_ADMIN) {
+            sales = params.contains("cashierId") ? db->getSalesByCashier(params.value("cashierId").toInt())
+                                                 : db->getAllSales();
+        } else if (session.role == ROLE_CASHIER) {
+            sales = db->getSalesByCashier(session.id);
+        } else {
+            return errorResponse("Недостаточно прав");
+        }
+        return resultResponse(listToJson(sales, saleToJson));
+    }
+
+    if (method == "sales.get") {
+        int saleId = params.value("saleId").toInt();
+        Sale sale = db->getSaleDetails(saleId);
+        if (sale.id == -1) {
+            return errorResponse("Чек не найден");
+        }
+        if (session.role != ROLE_ADMIN && sale.cashierId != session.id && sale.customerId != session.id) {
+            return errorResponse("Чек не найден");
+        }
+
+        QJsonObject json = saleToJson(sale);
+        json["items"] = listToJson(db->getSaleItems(saleId), saleItemToJson);
+        return resultResponse(json);
+    }
+
+    if (method == "sales.archive") {
+        QDate before = QDate::fromString(params.value("before").toString(), Qt::ISODate);
+        if (!before.isValid()) {
+            return errorResponse("Укажите before в формате yyyy-MM-dd");
+        }
+
+        int archived = db->archiveSales(before);
+        if (archived < 0) {
+            return errorResponse("Не удалось перенести продажи в архив");
+        }
+        return resultResponse(archived);
+    }
+
+    if (method == "reports.profit") {
+        QDate startDate = QDate::fromString(params.value("startDate").toString(), Qt::ISODate);
+        QDate endDate = QDate::fromString(params.value("endDate").toString(), Qt::ISODate);
+        if (!startDate.isValid() || !endDate.isValid()) {
+            return errorResponse("Укажите startDate и endDate в формате yyyy-MM-dd");
+        }
+
+        ProfitReport report = db->generateProfitReport(startDate, endDate);
+        if (db->lastError().isValid()) {
+            return errorResponse("Не удалось построить отчет: " + db->lastError().text());
+        }
+
+        QJsonArray popular;
+        for (const auto &entry : report.popularProducts) {
+            QJsonObject item;
+            item["name"] = entry.first;
+            item["quantity"] = entry.second;
+            popular.append(item);
+        }
+
+        QJsonObject json;
+        json["startDate"] = startDate.toString(Qt::ISODate);
+        json["endDate"] = endDate.toString(Qt::ISODate);
+        json["totalRevenue"] = report.totalRevenue;
+        json["totalCost"] = report.totalCost;
+        json["totalProfit"] = report.totalProfit;
+        json["popularProducts"] = popular;
+        return resultResponse(json);
+    }
+
+    return errorResponse("Неизвестный метод: " + method);
+}
@@ -0,0 +1,61 @@
+#ifndef STORESERVICE_H
+#define STORESERVICE_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QHash>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QMutex>
+#include <QThreadPool>
+#include <QTimer>
+#include "database.h"
+
+// Безоконный режим: операции Database доступны через локальный сокет.
+// Протокол - JSON по одному объекту на строку:
+//   запрос  {"id": 1, "method": "catalog.list", "params": {...}}
+//   ответ   {"id": 1, "result": ...} или {"id": 1, "error": "..."}
+// auth.login возвращает token; все остальные методы требуют его в params,
+// пользователь и роль берутся из сессии, а не из параметров запроса.
+// Запросы выполняются в пуле потоков, у каждого потока свое соединение с БД,
+// поэтому ответы могут приходить не в порядке запросов.
+class StoreService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StoreService(const QString &dbPath, int threadCount, QObject *parent = nullptr);
+    ~StoreService();
+
+    bool listen(const QString &name);
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onSnapshotTimer();
+
+private:
+    struct Session {
+        User user;
+        QDateTime lastSeen;
+    };
+
+    QLocalServer *server;
+    QThreadPool pool;
+    QTimer snapshotTimer;
+    QString dbPath;
+
+    // Запросы обрабатываются в пуле потоков, поэтому сессии под мьютексом
+    QHash<QString, Session> sessions;
+    QMutex sessionMutex;
+
+    void dispatch(QLocalSocket *socket, const QByteArray &line);
+    QJsonObject handleRequest(const QString &method, const QJsonObject &params);
+    Database *threadDatabase();
+    QString openSession(const User &user);
+    User sessionUser(const QString &token);
+    void closeSession(const QString &token);
+};
+
+#endif // STORESERVICE_H
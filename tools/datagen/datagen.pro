@@ -0,0 +1,17 @@
+QT += core sql
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = datagen
+
+SOURCES += \
+    datagenerator.cpp \
+    main.cpp
+
+HEADERS += \
+    datagenerator.h
+
+RESOURCES += \
+    ../../resources.qrc
@@ -0,0 +1,658 @@
+#include "datagenerator.h"
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariantList>
+#include <QtMath>
+#include <algorithm>
+
+struct CategorySpec {
+    const char *name;
+    double minPrice;
+    double maxPrice;
+    const char *nouns[3];
+};
+
+static const CategorySpec categorySpecs[] = {
+    {"Электроника", 500, 80000, {"Телевизор", "Наушники", "Колонка"}},
+    {"Бытовая техника", 1000, 60000, {"Пылесос", "Чайник", "Микроволновка"}},
+    {"Продукты питания", 30, 1500, {"Кофе", "Чай", "Печенье"}},
+    {"Одежда", 300, 8000, {"Футболка", "Фартук", "Перчатки"}},
+    {"Посуда", 100, 5000, {"Кастрюля", "Сковорода", "Тарелка"}},
+    {"Бытовая химия", 50, 1200, {"Порошок", "Гель", "Средство"}},
+    {"Текстиль", 200, 6000, {"Полотенце", "Плед", "Скатерть"}},
+    {"Инструменты", 150, 15000, {"Дрель", "Отвертка", "Молоток"}},
+    {"Сад и огород", 50, 8000, {"Лейка", "Секатор", "Грунт"}},
+    {"Освещение", 100, 7000, {"Лампа", "Светильник", "Гирлянда"}},
+    {"Хранение", 100, 3000, {"Контейнер", "Корзина", "Органайзер"}},
+    {"Товары для ванной", 80, 4000, {"Коврик", "Дозатор", "Шторка"}},
+};
+
+static const char *supplierNames[] = {
+    "ООО \"Снабжение\"", "ООО \"ДомТорг\"", "АО \"Оптовик\"",
+    "ИП Смирнов", "ООО \"ТехноПоставка\"", "ООО \"Хозтовары\"",
+};
+
+static const int categorySpecCount = sizeof(categorySpecs) / sizeof(categorySpecs[0]);
+static const int supplierCount = sizeof(supplierNames) / sizeof(supplierNames[0]);
+
+// Средний размер чека с учетом распределения в createSalesAndSupplies
+static const double averageUnitsPerSale = 2.2;
+static const int restockHorizonDays = 14;
+
+static QString hashPassword(const QString &password)
+{
+    return QCryptographicHash::hash(password.toUtf8(), QCryptographicHash::Sha256).toHex();
+}
+
+QStringList splitSqlScript(const QString &script)
+{
+    static const QRegularExpression blockKeyword("\\b(BEGIN|CASE|END)\\b",
+                                                 QRegularExpression::CaseInsensitiveOption);
+
+    QStringList statements;
+    QString current;
+    int depth = 0;
+
+    const QStringList lines = script.split('\n');
+    for (const QString &line : lines) {
+        QString trimmed = line.trimmed();
+        if (trimmed.isEmpty() || trimmed.startsWith("--")) {
+            continue;
+        }
+
+        // Тело триггера содержит вложенные ';' - считаем глубину BEGIN/CASE ... END
+        QRegularExpressionMatchIterator it = blockKeyword.globalMatch(trimmed);
+        while (it.hasNext()) {
+            QString keyword = it.next().captured(1).toUpper();
+            depth += keyword == "END" ? -1 : 1;
+        }
+
+        current += line + '\n';
+
+        if (depth <= 0 && trimmed.endsWith(';')) {
+            statements.append(current.trimmed());
+            current.clear();
+            depth = 0;
+        }
+    }
+
+    if (!current.trimmed().isEmpty()) {
+        statements.append(current.trimmed());
+    }
+
+    return statements;
+}
+
+DataGenerator::DataGenerator(const GeneratorOptions &options)
+    : options(options)
+    , random(options.seed)
+    , connectionName("datagen")
+    , adminId(1)
+    , nextSupplyId(1)
+    , nextSaleItemId(1)
+{
+}
+
+DataGenerator::~DataGenerator()
+{
+    if (db.isOpen()) {
+        db.close();
+    }
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+bool DataGenerator::exec(const QString &sql)
+{
+    QSqlQuery query(db);
+    if (!query.exec(sql)) {
+        qCritical() << "Ошибка SQL:" << query.lastError().text() << "\n" << sql;
+        return false;
+    }
+    return true;
+}
+
+bool DataGenerator::beginChunk()
+{
+    return exec("BEGIN");
+}
+
+bool DataGenerator::commitChunk()
+{
+    return exec("COMMIT");
+}
+
+bool DataGenerator::loadSchema()
+{
+    QFile file(options.schemaPath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qCritical() << "Не удалось открыть схему:" << options.schemaPath;
+        return false;
+    }
+
+    const QStringList statements = splitSqlScript(QString::fromUtf8(file.readAll()));
+
+    // Пользователей и категории генератор создает сам, начальные данные
+    // остальных таблиц (например, акции) берутся из схемы как есть
+    static const QStringList generatedTables = {"users", "product_categories"};
+    static const QRegularExpression insertTarget("^INSERT\\s+(?:OR\\s+\\w+\\s+)?INTO\\s+(\\w+)",
+                                                 QRegularExpression::CaseInsensitiveOption);
+
+    // Таблицы создаются до загрузки, индексы и триггеры - после нее:
+    // все вычисляемые поля генератор заполняет сам.
+    for (const QString &statement : statements) {
+        QRegularExpressionMatch insert = insertTarget.match(statement);
+
+        if (statement.startsWith("CREATE TABLE", Qt::CaseInsensitive)) {
+            preLoadStatements.append(statement);
+        } else if (insert.hasMatch()) {
+            if (!generatedTables.contains(insert.captured(1), Qt::CaseInsensitive)) {
+                seedStatements.append(statement);
+            }
+        } else if (statement.startsWith("PRAGMA foreign_keys", Qt::CaseInsensitive)) {
+            continue;
+        } else {
+            postLoadStatements.append(statement);
+        }
+    }
+
+    return !preLoadStatements.isEmpty();
+}
+
+bool DataGenerator::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if (!loadSchema()) {
+        return false;
+    }
+
+    db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName(options.outputPath);
+    if (!db.open()) {
+        qCritical() << "Ошибка подключения к базе данных:" << db.lastError().text();
+        return false;
+    }
+
+    // Режим массовой загрузки: база создается с нуля, поэтому журнал и fsync не нужны.
+    if (!exec("PRAGMA journal_mode = OFF")
+        || !exec("PRAGMA synchronous = OFF")
+        || !exec("PRAGMA temp_store = MEMORY")
+        || !exec("PRAGMA cache_size = -262144")
+        || !exec("PRAGMA locking_mode = EXCLUSIVE")) {
+        return false;
+    }
+
+    for (const QString &statement : preLoadStatements + seedStatements) {
+        if (!exec(statement)) {
+            return false;
+        }
+    }
+
+    if (!createUsers() || !createCategories()) {
+        return false;
+    }
+
+    prepareProducts();
+
+    if (!createSalesAndSupplies() || !writeProducts() || !writeStockLedger() || !finalizeSchema()) {
+        return false;
+    }
+
+    qInfo() << "Готово за" << timer.elapsed() / 1000.0 << "с:" << options.outputPath;
+    return true;
+}
+
+bool DataGenerator::createUsers()
+{
+    QVariantList ids, logins, passwords, roles;
+
+    auto addUser = [&](int id, const QString &login, const QString &password, const QString &role) {
+        ids << id;
+        logins << login;
+        passwords << hashPassword(password);
+        roles << role;
+    };
+
+    int nextId = 1;
+    adminId = nextId;
+    addUser(nextId++, "admin", "admin123", "Администратор");
+
+    for (int i = 1; i <= options.cashierCount; i++) {
+        cashierIds.append(nextId);
+        addUser(nextId++, QString("cashier%1").arg(i), "cashier123", "Кассир");
+    }
+
+    for (int i = 1; i <= options.clientCount; i++) {
+        clientIds.append(nextId);
+        addUser(nextId++, QString("client%1").arg(i), "client123", "Клиент");
+    }
+
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO users (id, login, password, role) VALUES (?, ?, ?, ?)");
+    query.addBindValue(ids);
+    query.addBindValue(logins);
+    query.addBindValue(passwords);
+    query.addBindValue(roles);
+
+    if (!beginChunk() || !query.execBatch() || !commitChunk()) {
+        qCritical() << "Ошибка при создании пользователей:" << query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+bool DataGenerator::createCategories()
+{
+    QVariantList ids, names;
+    for (int i = 0; i < categorySpecCount; i++) {
+        categoryIds.append(i + 1);
+        ids << i + 1;
+        names << QString::fromUtf8(categorySpecs[i].name);
+    }
+
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO product_categories (id, name) VALUES (?, ?)");
+    query.addBindValue(ids);
+    query.addBindValue(names);
+
+    if (!beginChunk() || !query.execBatch() || !commitChunk()) {
+        qCritical() << "Ошибка при создании категорий:" << query.lastError().text();
+        return false;
+    }
+
+    return true;
+}
+
+void DataGenerator::prepareProducts()
+{
+    int count = options.productCount;
+
+    productCategories.resize(count);
+    productNames.resize(count);
+    purchasePrices.resize(count);
+    retailPrices.resize(count);
+    stock.fill(0, count);
+
+    for (int i = 0; i < count; i++) {
+        int category = random.bounded(categorySpecCount);
+        const CategorySpec &spec = categorySpecs[category];
+
+        double logMin = qLn(spec.minPrice);
+        double logMax = qLn(spec.maxPrice);
+        double purchase = qExp(logMin + random.generateDouble() * (logMax - logMin));
+        double markup = 1.15 + random.generateDouble() * 0.45;
+
+        productCategories[i] = category;
+        productNames[i] = QString("%1 %2-%3")
+                              .arg(QString::fromUtf8(spec.nouns[random.bounded(3)]))
+                              .arg(QChar('A' + random.bounded(26)))
+                              .arg(i + 1);
+        purchasePrices[i] = qRound(purchase * 100) / 100.0;
+        retailPrices[i] = qRound(purchase * markup * 100) / 100.0;
+    }
+
+    // Популярность по закону Ципфа; ранги перемешаны, чтобы хиты продаж
+    // не шли подряд по id.
+    QVector<int> ranks(count);
+    for (int i = 0; i < count; i++) {
+        ranks[i] = i + 1;
+    }
+    for (int i = count - 1; i > 0; i--) {
+        std::swap(ranks[i], ranks[random.bounded(i + 1)]);
+    }
+
+    popularityCdf.resize(count);
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += 1.0 / qPow(ranks[i], options.popularitySkew);
+        popularityCdf[i] = sum;
+    }
+    for (int i = 0; i < count; i++) {
+        popularityCdf[i] /= sum;
+    }
+}
+
+double DataGenerator::seasonalFactor(const QDate &date) const
+{
+    // Годовая волна с пиком в конце декабря и провалом летом
+    double yearPhase = 2 * M_PI * (date.dayOfYear() - 355) / 365.0;
+    double factor = 1.0 + 0.25 * qCos(yearPhase);
+
+    if (date.month() == 12 && date.day() >= 20) {
+        factor *= 1.6;
+    } else if (date.month() == 3 && date.day() <= 7) {
+        factor *= 1.25;
+    }
+
+    switch (date.dayOfWeek()) {
+    case 5:
+        factor *= 1.1;
+        break;
+    case 6:
+        factor *= 1.3;
+        break;
+    case 7:
+        factor *= 1.2;
+        break;
+    default:
+        break;
+    }
+
+    return factor;
+}
+
+int DataGenerator::pickProduct()
+{
+    double value = random.generateDouble();
+    auto it = std::lower_bound(popularityCdf.constBegin(), popularityCdf.constEnd(), value);
+    if (it == popularityCdf.constEnd()) {
+        return popularityCdf.size() - 1;
+    }
+    return static_cast<int>(it - popularityCdf.constBegin());
+}
+
+int DataGenerator::restockQuantity(int productIndex, int required)
+{
+    double share = popularityCdf[productIndex] - (productIndex > 0 ? popularityCdf[productIndex - 1] : 0.0);
+    double dailyDemand = options.saleCount * averageUnitsPerSale * share / options.days;
+    int quantity = qCeil(dailyDemand * restockHorizonDays / 10.0) * 10;
+
+    return qMax(qMax(quantity, 10), required);
+}
+
+bool DataGenerator::createSalesAndSupplies()
+{
+    QDate startDate = options.endDate.addDays(-(options.days - 1));
+
+    QVector<double> dayWeights(options.days);
+    double weightSum = 0;
+    for (int d = 0; d < options.days; d++) {
+        // Небольшой рост продаж со временем
+        double trend = 1.0 + 0.1 * d / 365.0;
+        dayWeights[d] = seasonalFactor(startDate.addDays(d)) * trend;
+        weightSum += dayWeights[d];
+    }
+
+    QSqlQuery supplyQuery(db);
+    supplyQuery.prepare("INSERT INTO supplies (id, supply_number, supplier_name, product_id, quantity, "
+                        "purchase_price, total_amount, supply_date, created_by, created_at) "
+                        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+    QSqlQuery saleQuery(db);
+    saleQuery.prepare("INSERT INTO sales (id, receipt_number, sale_date, cashier_id, customer_id, "
+                      "total_amount, discount_amount, final_amount, created_at) "
+                      "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+    QSqlQuery itemQuery(db);
+    itemQuery.prepare("INSERT INTO sale_items (id, sale_id, product_id, quantity, retail_price, total_price) "
+                      "VALUES (?, ?, ?, ?, ?, ?)");
+
+    QVariantList supplyIds, supplyNumbers, supplySuppliers, supplyProducts, supplyQuantities,
+        supplyPrices, supplyTotals, supplyDates, supplyCreatedBy;
+    QVariantList saleIds, saleReceipts, saleDates, saleCashiers, saleCustomers,
+        saleTotals, saleDiscounts, saleFinals;
+    QVariantList itemIds, itemSales, itemProducts, itemQuantities, itemPrices, itemTotals;
+
+    auto addSupply = [&](int productIndex, int quantity, const QDateTime &date) {
+        qint64 id = nextSupplyId++;
+        supplyIds << id;
+        supplyNumbers << QString("SUP%1").arg(id, 10, 10, QChar('0'));
+        supplySuppliers << QString::fromUtf8(supplierNames[random.bounded(supplierCount)]);
+        supplyProducts << productIndex + 1;
+        supplyQuantities << quantity;
+        supplyPrices << purchasePrices[productIndex];
+        supplyTotals << quantity * purchasePrices[productIndex];
+        supplyDates << date;
+        supplyCreatedBy << adminId;
+        stock[productIndex] += quantity;
+    };
+
+    auto flush = [&]() -> bool {
+        if (saleIds.isEmpty() && supplyIds.isEmpty()) {
+            return true;
+        }
+
+        if (!beginChunk()) {
+            return false;
+        }
+
+        if (!supplyIds.isEmpty()) {
+            supplyQuery.addBindValue(supplyIds);
+            supplyQuery.addBindValue(supplyNumbers);
+            supplyQuery.addBindValue(supplySuppliers);
+            supplyQuery.addBindValue(supplyProducts);
+            supplyQuery.addBindValue(supplyQuantities);
+            supplyQuery.addBindValue(supplyPrices);
+            supplyQuery.addBindValue(supplyTotals);
+            supplyQuery.addBindValue(supplyDates);
+            supplyQuery.addBindValue(supplyCreatedBy);
+            supplyQuery.addBindValue(supplyDates);
+            if (!supplyQuery.execBatch()) {
+                qCritical() << "Ошибка при вставке поставок:" << supplyQuery.lastError().text();
+                return false;
+            }
+        }
+
+        if (!saleIds.isEmpty()) {
+            saleQuery.addBindValue(saleIds);
+            saleQuery.addBindValue(saleReceipts);
+            saleQuery.addBindValue(saleDates);
+            saleQuery.addBindValue(saleCashiers);
+            saleQuery.addBindValue(saleCustomers);
+            saleQuery.addBindValue(saleTotals);
+            saleQuery.addBindValue(saleDiscounts);
+            saleQuery.addBindValue(saleFinals);
+            saleQuery.addBindValue(saleDates);
+            if (!saleQuery.execBatch()) {
+                qCritical() << "Ошибка при вставке продаж:" << saleQuery.lastError().text();
+                return false;
+            }
+
+            itemQuery.addBindValue(itemIds);
+            itemQuery.addBindValue(itemSales);
+            itemQuery.addBindValue(itemProducts);
+            itemQuery.addBindValue(itemQuantities);
+            itemQuery.addBindValue(itemPrices);
+            itemQuery.addBindValue(itemTotals);
+            if (!itemQuery.execBatch()) {
+                qCritical() << "Ошибка при вставке позиций продаж:" << itemQuery.lastError().text();
+                return false;
+            }
+        }
+
+        if (!commitChunk()) {
+            return false;
+        }
+
+        for (QVariantList *list : {&supplyIds, &supplyNumbers, &supplySuppliers, &supplyProducts,
+                                   &supplyQuantities, &supplyPrices, &supplyTotals, &supplyDates,
+                                   &supplyCreatedBy, &saleIds, &saleReceipts, &saleDates, &saleCashiers,
+                                   &saleCustomers, &saleTotals, &saleDiscounts, &saleFinals, &itemIds,
+                                   &itemSales, &itemProducts, &itemQuantities, &itemPrices, &itemTotals}) {
+            list->clear();
+        }
+        return true;
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QDateTime openingDate(startDate, QTime(8, 0));
+    for (int i = 0; i < options.productCount; i++) {
+        addSupply(i, restockQuantity(i, 0), openingDate);
+    }
+
+    qint64 saleId = 0;
+    double cumulativeWeight = 0;
+    QVector<int> saleProducts;
+
+    for (int d = 0; d < options.days; d++) {
+        QDate date = startDate.addDays(d);
+        cumulativeWeight += dayWeights[d];
+
+        qint64 target = qRound64(options.saleCount * cumulativeWeight / weightSum);
+        int daySales = static_cast<int>(target - saleId);
+
+        QVector<int> seconds(daySales);
+        for (int s = 0; s < daySales; s++) {
+            seconds[s] = 9 * 3600 + random.bounded(12 * 3600);
+        }
+        std::sort(seconds.begin(), seconds.end());
+
+        for (int s = 0; s < daySales; s++) {
+            QDateTime saleDate(date, QTime(0, 0).addSecs(seconds[s]));
+            qint64 id = ++saleId;
+
+            int itemCount = 1;
+            while (itemCount < options.maxItemsPerSale && random.generateDouble() < 0.45) {
+                itemCount++;
+            }
+
+            saleProducts.clear();
+            double total = 0;
+
+            for (int n = 0; n < itemCount; n++) {
+                int product = pickProduct();
+                if (saleProducts.contains(product)) {
+                    continue;
+                }
+                saleProducts.append(product);
+
+                int quantity = random.bounded(10) == 0 ? 2 + random.bounded(4) : 1;
+                if (stock[product] < quantity) {
+                    addSupply(product, restockQuantity(product, quantity), QDateTime(date, QTime(8, 0)));
+                }
+                stock[product] -= quantity;
+
+                double lineTotal = quantity * retailPrices[product];
+                total += lineTotal;
+
+                itemIds << nextSaleItemId++;
+                itemSales << id;
+                itemProducts << product + 1;
+                itemQuantities << quantity;
+                itemPrices << retailPrices[product];
+                itemTotals << lineTotal;
+            }
+
+            bool byClient = !clientIds.isEmpty() && random.bounded(100) < 15;
+            double discount = random.bounded(100) < 15 ? (random.bounded(2) + 1) * 5.0 : 0.0;
+
+            saleIds << id;
+            saleReceipts << QString("CHK%1").arg(id, 12, 10, QChar('0'));
+            saleDates << saleDate;
+            saleCashiers << (byClient || cashierIds.isEmpty()
+                                 ? QVariant()
+                                 : cashierIds[random.bounded(cashierIds.size())]);
+            saleCustomers << (byClient ? clientIds[random.bounded(clientIds.size())] : QVariant());
+            saleTotals << total;
+            saleDiscounts << discount;
+            saleFinals << total * (1 - discount / 100.0);
+
+            if (saleIds.size() >= options.chunkSize) {
+                if (!flush()) {
+                    return false;
+                }
+                qInfo().noquote() << QString("Продажи: %1 / %2 (%3 строк/с)")
+                                         .arg(saleId)
+                                         .arg(options.saleCount)
+                                         .arg(qRound64(nextSaleItemId * 1000.0 / qMax<qint64>(1, timer.elapsed())));
+            }
+        }
+    }
+
+    if (!flush()) {
+        return false;
+    }
+
+    qInfo() << "Продаж:" << saleId << "позиций:" << nextSaleItemId - 1
+            << "поставок:" << nextSupplyId - 1;
+    return true;
+}
+
+bool DataGenerator::writeProducts()
+{
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO products (id, article, name, category_id, purchase_price, "
+                  "retail_price, created_at, updated_at) "
+                  "VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+
+    QDateTime createdAt(options.endDate.addDays(-(options.days - 1)), QTime(8, 0));
+    QDateTime updatedAt(options.endDate, QTime(21, 0));
+
+    for (int offset = 0; offset < options.productCount; offset += options.chunkSize) {
+        int end = qMin(offset + options.chunkSize, options.productCount);
+
+        QVariantList ids, articles, names, categories, purchase, retail, created, updated;
+        for (int i = offset; i < end; i++) {
+            ids << i + 1;
+            articles << QString("ART%1").arg(i + 1, 8, 10, QChar('0'));
+            names << productNames[i];
+            categories << categoryIds[productCategories[i]];
+            purchase << purchasePrices[i];
+            retail << retailPrices[i];
+            created << createdAt;
+            updated << updatedAt;
+        }
+
+        query.addBindValue(ids);
+        query.addBindValue(articles);
+        query.addBindValue(names);
+        query.addBindValue(categories);
+        query.addBindValue(purchase);
+        query.addBindValue(retail);
+        query.addBindValue(created);
+        query.addBindValue(updated);
+
+        if (!beginChunk() || !query.execBatch() || !commitChunk()) {
+            qCritical() << "Ошибка при вставке товаров:" << query.lastError().text();
+            return false;
+        }
+    }
+
+    productNames.clear();
+    return true;
+}
+
+bool DataGenerator::writeStockLedger()
+{
+    qInfo() << "Формирование журнала движений остатков...";
+
+    // Журнал строится из уже загруженных поставок и продаж в порядке дат,
+    // снимок по последнему движению дает product_stock без суммирования истории
+    return beginChunk()
+           && exec("INSERT INTO stock_movements (product_id, quantity, reason, reference_id, created_at) "
+                   "SELECT product_id, quantity, reason, reference_id, created_at FROM ("
+                   "SELECT product_id, quantity, 'supply' AS reason, id AS reference_id, "
+                   "supply_date AS created_at FROM supplies "
+                   "UNION ALL "
+                   "SELECT si.product_id, -si.quantity, 'sale', si.sale_id, s.sale_date "
+                   "FROM sale_items si JOIN sales s ON s.id = si.sale_id) "
+                   "ORDER BY created_at, reason DESC")
+           && exec("INSERT INTO stock_snapshots (product_id, stock, movement_id, created_at) "
+                   "SELECT product_id, SUM(quantity), "
+                   "(SELECT COALESCE(MAX(id), 0) FROM stock_movements), CURRENT_TIMESTAMP "
+                   "FROM stock_movements GROUP BY product_id")
+           && commitChunk();
+}
+
+bool DataGenerator::finalizeSchema()
+{
+    qInfo() << "Создание индексов и триггеров...";
+
+    for (const QString &statement : postLoadStatements) {
+        if (!exec(statement)) {
+            return false;
+        }
+    }
+
+    return exec("ANALYZE") && exec("PRAGMA journal_mode = DELETE");
+}
@@ -0,0 +1,79 @@
+#ifndef DATAGENERATOR_H
+#define DATAGENERATOR_H
+
+#include <QDate>
+#include <QRandomGenerator>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct GeneratorOptions {
+    QString outputPath;
+    QString schemaPath;
+    int productCount;
+    int saleCount;
+    int maxItemsPerSale;
+    int cashierCount;
+    int clientCount;
+    QDate endDate;
+    int days;
+    quint32 seed;
+    int chunkSize;
+    double popularitySkew;
+};
+
+class DataGenerator
+{
+public:
+    explicit DataGenerator(const GeneratorOptions &options);
+    ~DataGenerator();
+
+    bool run();
+
+private:
+    GeneratorOptions options;
+    QRandomGenerator random;
+    QSqlDatabase db;
+    QString connectionName;
+
+    QStringList preLoadStatements;
+    QStringList seedStatements;
+    QStringList postLoadStatements;
+
+    int adminId;
+    QVector<int> cashierIds;
+    QVector<int> clientIds;
+    QVector<int> categoryIds;
+
+    QVector<int> productCategories;
+    QVector<QString> productNames;
+    QVector<double> purchasePrices;
+    QVector<double> retailPrices;
+    QVector<double> popularityCdf;
+    QVector<int> stock;
+
+    qint64 nextSupplyId;
+    qint64 nextSaleItemId;
+
+    bool loadSchema();
+    bool exec(const QString &sql);
+    bool beginChunk();
+    bool commitChunk();
+
+    bool createUsers();
+    bool createCategories();
+    void prepareProducts();
+    bool createSalesAndSupplies();
+    bool writeProducts();
+    bool writeStockLedger();
+    bool finalizeSchema();
+
+    double seasonalFactor(const QDate &date) const;
+    int pickProduct();
+    int restockQuantity(int productIndex, int required);
+};
+
+QStringList splitSqlScript(const QString &script);
+
+#endif // DATAGENERATOR_H
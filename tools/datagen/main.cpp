@@ -0,0 +1,67 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include "datagenerator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("datagen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Генератор тестовой базы shop.db по схеме scripts/database.sql");
+    parser.addHelpOption();
+
+    QCommandLineOption outputOption({"o", "output"}, "Файл создаваемой базы.", "file", "shop.db");
+    QCommandLineOption schemaOption("schema", "SQL-схема базы.", "file", ":/scripts/database.sql");
+    QCommandLineOption productsOption("products", "Количество товаров.", "count", "100000");
+    QCommandLineOption salesOption("sales", "Количество продаж.", "count", "1000000");
+    QCommandLineOption itemsOption("max-items", "Максимум позиций в чеке.", "count", "8");
+    QCommandLineOption cashiersOption("cashiers", "Количество кассиров.", "count", "20");
+    QCommandLineOption clientsOption("clients", "Количество клиентов.", "count", "2000");
+    QCommandLineOption daysOption("days", "Длина истории в днях.", "count", "730");
+    QCommandLineOption endDateOption("end-date", "Последний день истории (yyyy-MM-dd).", "date",
+                                     QDate::currentDate().toString("yyyy-MM-dd"));
+    QCommandLineOption seedOption("seed", "Зерно генератора случайных чисел.", "number", "1");
+    QCommandLineOption chunkOption("chunk", "Продаж в одной транзакции.", "count", "20000");
+    QCommandLineOption skewOption("skew", "Показатель распределения Ципфа для популярности товаров.",
+                                  "value", "1.1");
+    QCommandLineOption forceOption({"f", "force"}, "Перезаписать существующий файл.");
+
+    parser.addOptions({outputOption, schemaOption, productsOption, salesOption, itemsOption,
+                       cashiersOption, clientsOption, daysOption, endDateOption, seedOption,
+                       chunkOption, skewOption, forceOption});
+    parser.process(app);
+
+    GeneratorOptions options;
+    options.outputPath = parser.value(outputOption);
+    options.schemaPath = parser.value(schemaOption);
+    options.productCount = parser.value(productsOption).toInt();
+    options.saleCount = parser.value(salesOption).toInt();
+    options.maxItemsPerSale = parser.value(itemsOption).toInt();
+    options.cashierCount = parser.value(cashiersOption).toInt();
+    options.clientCount = parser.value(clientsOption).toInt();
+    options.days = parser.value(daysOption).toInt();
+    options.endDate = QDate::fromString(parser.value(endDateOption), "yyyy-MM-dd");
+    options.seed = parser.value(seedOption).toUInt();
+    options.chunkSize = parser.value(chunkOption).toInt();
+    options.popularitySkew = parser.value(skewOption).toDouble();
+
+    if (options.productCount <= 0 || options.saleCount < 0 || options.maxItemsPerSale <= 0
+        || options.days <= 0 || options.chunkSize <= 0 || !options.endDate.isValid()) {
+        qCritical() << "Некорректные параметры генерации";
+        return 1;
+    }
+
+    if (QFile::exists(options.outputPath)) {
+        if (!parser.isSet(forceOption)) {
+            qCritical() << "Файл уже существует:" << options.outputPath << "(используйте --force)";
+            return 1;
+        }
+        QFile::remove(options.outputPath);
+    }
+
+    DataGenerator generator(options);
+    return generator.run() ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+QT += core sql
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = loadtest
+
+include(../../database.pri)
+
+SOURCES += \
+    loadworker.cpp \
+    main.cpp
+
+HEADERS += \
+    loadworker.h
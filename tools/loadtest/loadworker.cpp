@@ -0,0 +1,171 @@
+#include "loadworker.h"
+#include <QElapsedTimer>
+
+LoadWorker::LoadWorker(int index, const LoadOptions &options, const QVector<CatalogEntry> &catalog,
+                       int cashierId, int clientId, QObject *parent)
+    : QThread(parent)
+    , index(index)
+    , options(options)
+    , catalog(catalog)
+    , cashierId(cashierId)
+    , clientId(clientId)
+    , random(options.seed + static_cast<quint32>(index))
+{
+}
+
+void LoadWorker::run()
+{
+    Database db;
+    if (!db.connectToDatabase(options.dbPath)) {
+        qWarning() << "Касса" << index << "не смогла подключиться к базе";
+        return;
+    }
+
+    // Равномерный темп: каждая касса выполняет свою долю от общей целевой нагрузки
+    qint64 intervalNs = options.targetRate > 0
+                            ? static_cast<qint64>(options.workers * 1e9 / options.targetRate)
+                            : 0;
+    qint64 durationNs = static_cast<qint64>(options.durationSec) * 1000000000LL;
+    qint64 nextStartNs = 0;
+
+    QElapsedTimer clock;
+    clock.start();
+
+    while (clock.nsecsElapsed() < durationNs) {
+        if (intervalNs > 0) {
+            qint64 waitNs = nextStartNs - clock.nsecsElapsed();
+            if (waitNs > 0) {
+                QThread::usleep(static_cast<unsigned long>(waitNs / 1000));
+            }
+            nextStartNs += intervalNs;
+        }
+
+        LoadOperation operation = pickOperation();
+        workerStats.attempts[operation]++;
+
+        qint64 startedNs = clock.nsecsElapsed();
+        bool success = false;
+
+        switch (operation) {
+        case SaleOperation:
+            success = runSale(db);
+            break;
+        case CartOperation:
+            success = runCart(db);
+            break;
+        case ClientOperation:
+            success = runClientSale(db);
+            break;
+        default:
+            break;
+        }
+
+        if (success) {
+            workerStats.successes[operation]++;
+            workerStats.latenciesNs[operation].append(clock.nsecsElapsed() - startedNs);
+        }
+    }
+}
+
+LoadOperation LoadWorker::pickOperation()
+{
+    int total = 0;
+    for (int weight : options.weights) {
+        total += weight;
+    }
+
+    int value = random.bounded(total);
+    for (int i = 0; i < OperationCount; i++) {
+        if (value < options.weights[i]) {
+            return static_cast<LoadOperation>(i);
+        }
+        value -= options.weights[i];
+    }
+
+    return SaleOperation;
+}
+
+bool LoadWorker::checkResult(Database &db, LoadOperation operation, bool success)
+{
+    // Повторы при SQLITE_BUSY выполняет сам Database, здесь только учет исхода
+    if (success) {
+        return true;
+    }
+
+    if (Database::isBusyError(db.lastError())) {
+        workerStats.busyFailures[operation]++;
+    } else {
+        workerStats.rejections[operation]++;
+    }
+    return false;
+}
+
+bool LoadWorker::runSale(Database &db)
+{
+    QList<SaleItem> items;
+    int count = 1 + random.bounded(options.maxItems);
+
+    for (int i = 0; i < count; i++) {
+        const CatalogEntry &entry = catalog[random.bounded(catalog.size())];
+
+        SaleItem item;
+        item.productId = entry.productId;
+        item.quantity = 1;
+        item.retailPrice = entry.retailPrice;
+        item.totalPrice = entry.retailPrice;
+        items.append(item);
+    }
+
+    Sale sale;
+    sale.cashierId = cashierId;
+    sale.customerId = -1;
+    sale.totalAmount = 0;
+    for (const SaleItem &item : items) {
+        sale.totalAmount += item.totalPrice;
+    }
+    sale.discountAmount = 0;
+    sale.finalAmount = sale.totalAmount;
+
+    bool success = checkResult(db, SaleOperation, db.createSale(sale, items) != -1);
+
+    if (success) {
+        workerStats.committedSales++;
+    }
+    return success;
+}
+
+bool LoadWorker::runCart(Database &db)
+{
+    int productId = catalog[random.bounded(catalog.size())].productId;
+
+    if (!checkResult(db, CartOperation, db.addToCart(clientId, productId, 1))) {
+        return false;
+    }
+
+    return checkResult(db, CartOperation, db.removeFromCart(clientId, productId));
+}
+
+bool LoadWorker::runClientSale(Database &db)
+{
+    int count = 1 + random.bounded(options.maxItems);
+
+    for (int i = 0; i < count; i++) {
+        int productId = catalog[random.bounded(catalog.size())].productId;
+        if (!checkResult(db, ClientOperation, db.addToCart(clientId, productId, 1))) {
+            db.clearCart(clientId);
+            return false;
+        }
+    }
+
+    Sale sale;
+    sale.customerId = clientId;
+    sale.discountAmount = 0;
+
+    bool success = checkResult(db, ClientOperation, db.createSaleForClient(sale));
+    if (success) {
+        workerStats.committedSales++;
+    } else {
+        db.clearCart(clientId);
+    }
+    return success;
+}
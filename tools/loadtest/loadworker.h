@@ -0,0 +1,69 @@
+#ifndef LOADWORKER_H
+#define LOADWORKER_H
+
+#include <QThread>
+#include <QRandomGenerator>
+#include <QVector>
+#include "database.h"
+
+enum LoadOperation {
+    SaleOperation,
+    CartOperation,
+    ClientOperation,
+    OperationCount
+};
+
+struct LoadOptions {
+    QString dbPath;
+    int workers;
+    int durationSec;
+    double targetRate;
+    int weights[OperationCount];
+    int maxItems;
+    quint32 seed;
+};
+
+struct CatalogEntry {
+    int productId;
+    double retailPrice;
+};
+
+struct WorkerStats {
+    qint64 attempts[OperationCount] = {};
+    qint64 successes[OperationCount] = {};
+    qint64 busyFailures[OperationCount] = {};
+    qint64 rejections[OperationCount] = {};
+    qint64 committedSales = 0;
+    QVector<qint64> latenciesNs[OperationCount];
+};
+
+class LoadWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    LoadWorker(int index, const LoadOptions &options, const QVector<CatalogEntry> &catalog,
+               int cashierId, int clientId, QObject *parent = nullptr);
+
+    const WorkerStats &stats() const { return workerStats; }
+
+protected:
+    void run() override;
+
+private:
+    int index;
+    LoadOptions options;
+    QVector<CatalogEntry> catalog;
+    int cashierId;
+    int clientId;
+    QRandomGenerator random;
+    WorkerStats workerStats;
+
+    LoadOperation pickOperation();
+    bool runSale(Database &db);
+    bool runCart(Database &db);
+    bool runClientSale(Database &db);
+    bool checkResult(Database &db, LoadOperation operation, bool success);
+};
+
+#endif // LOADWORKER_H
@@ -0,0 +1,280 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTextStream>
+#include <algorithm>
+#include "loadworker.h"
+
+static const char *operationNames[OperationCount] = {"createSale", "addToCart", "createSaleForClient"};
+
+struct StoreState {
+    qint64 maxSaleId = 0;
+    qint64 saleCount = 0;
+    QHash<int, qint64> stock;
+    QHash<int, qint64> reserved;
+    QHash<int, qint64> sold;
+    qint64 negativeStock = 0;
+};
+
+static bool readState(QSqlDatabase &db, qint64 sinceSaleId, StoreState &state)
+{
+    QSqlQuery query(db);
+
+    if (!query.exec("SELECT COALESCE(MAX(id), 0) FROM sales") || !query.next()) {
+        return false;
+    }
+    state.maxSaleId = query.value(0).toLongLong();
+
+    query.prepare("SELECT COUNT(*) FROM sales WHERE id > :since");
+    query.bindValue(":since", sinceSaleId);
+    if (!query.exec() || !query.next()) {
+        return false;
+    }
+    state.saleCount = query.value(0).toLongLong();
+
+    if (!query.exec("SELECT product_id, stock FROM product_stock")) {
+        return false;
+    }
+    while (query.next()) {
+        qint64 stock = query.value(1).toLongLong();
+        state.stock.insert(query.value(0).toInt(), stock);
+        if (stock < 0) {
+            state.negativeStock++;
+        }
+    }
+
+    if (!query.exec("SELECT product_id, SUM(quantity) FROM cart_items GROUP BY product_id")) {
+        return false;
+    }
+    while (query.next()) {
+        state.reserved.insert(query.value(0).toInt(), query.value(1).toLongLong());
+    }
+
+    query.prepare("SELECT product_id, SUM(quantity) FROM sale_items WHERE sale_id > :since GROUP BY product_id");
+    query.bindValue(":since", sinceSaleId);
+    if (!query.exec()) {
+        return false;
+    }
+    while (query.next()) {
+        state.sold.insert(query.value(0).toInt(), query.value(1).toLongLong());
+    }
+
+    return true;
+}
+
+static qint64 percentile(const QVector<qint64> &sorted, double p)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    int index = qBound(0, static_cast<int>(p * (sorted.size() - 1) + 0.5), sorted.size() - 1);
+    return sorted[index];
+}
+
+static QString formatMs(qint64 ns)
+{
+    return QString::number(ns / 1e6, 'f', 2);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("loadtest");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Нагрузочный тест оформления продаж с нескольких касс");
+    parser.addHelpOption();
+
+    QCommandLineOption dbOption("db", "Файл базы данных.", "file", "shop.db");
+    QCommandLineOption workersOption({"w", "workers"}, "Количество касс (потоков).", "count", "4");
+    QCommandLineOption durationOption({"d", "duration"}, "Длительность теста в секундах.", "seconds", "30");
+    QCommandLineOption rateOption("rate", "Целевая нагрузка, операций/с на все кассы (0 - без ограничения).",
+                                  "ops", "0");
+    QCommandLineOption mixOption("mix", "Доли операций createSale,addToCart,createSaleForClient.",
+                                 "weights", "70,20,10");
+    QCommandLineOption itemsOption("max-items", "Максимум позиций в чеке.", "count", "5");
+    QCommandLineOption seedOption("seed", "Зерно генератора случайных чисел.", "number", "1");
+
+    parser.addOptions({dbOption, workersOption, durationOption, rateOption, mixOption,
+                       itemsOption, seedOption});
+    parser.process(app);
+
+    LoadOptions options;
+    options.dbPath = parser.value(dbOption);
+    options.workers = parser.value(workersOption).toInt();
+    options.durationSec = parser.value(durationOption).toInt();
+    options.targetRate = parser.value(rateOption).toDouble();
+    options.maxItems = parser.value(itemsOption).toInt();
+    options.seed = parser.value(seedOption).toUInt();
+
+    const QStringList weights = parser.value(mixOption).split(',');
+    int weightSum = 0;
+    for (int i = 0; i < OperationCount; i++) {
+        options.weights[i] = i < weights.size() ? qMax(0, weights[i].trimmed().toInt()) : 0;
+        weightSum += options.weights[i];
+    }
+
+    QTextStream out(stdout);
+
+    if (options.workers <= 0 || options.durationSec <= 0 || options.maxItems <= 0 || weightSum <= 0) {
+        out << "Некорректные параметры теста\n";
+        return 1;
+    }
+
+    if (!QFile::exists(options.dbPath)) {
+        out << "База данных не найдена: " << options.dbPath << "\n";
+        return 1;
+    }
+
+    QVector<CatalogEntry> catalog;
+    QVector<int> cashierIds;
+    QVector<int> clientIds;
+    StoreState before;
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "loadtest_setup");
+        db.setDatabaseName(options.dbPath);
+        if (!db.open()) {
+            out << "Не удалось открыть базу: " << db.lastError().text() << "\n";
+            return 1;
+        }
+
+        QSqlQuery query(db);
+        query.exec("SELECT p.id, p.retail_price FROM products p "
+                   "JOIN product_stock ps ON ps.product_id = p.id WHERE ps.stock > 0");
+        while (query.next()) {
+            catalog.append({query.value(0).toInt(), query.value(1).toDouble()});
+        }
+
+        query.exec("SELECT id, role FROM users ORDER BY id");
+        while (query.next()) {
+            if (query.value(1).toString() == "Кассир") {
+                cashierIds.append(query.value(0).toInt());
+            } else if (query.value(1).toString() == "Клиент") {
+                clientIds.append(query.value(0).toInt());
+            }
+        }
+
+        if (!readState(db, 0, before)) {
+            out << "Не удалось прочитать состояние базы\n";
+            return 1;
+        }
+    }
+    QSqlDatabase::removeDatabase("loadtest_setup");
+
+    if (catalog.isEmpty() || cashierIds.isEmpty() || clientIds.isEmpty()) {
+        out << "В базе нужны товары в наличии, кассиры и клиенты (см. tools/datagen)\n";
+        return 1;
+    }
+
+    if (clientIds.size() < options.workers) {
+        out << "Внимание: клиентов меньше, чем касс - корзины будут общими\n";
+    }
+
+    QList<LoadWorker *> workers;
+    for (int i = 0; i < options.workers; i++) {
+        workers.append(new LoadWorker(i, options, catalog,
+                                      cashierIds[i % cashierIds.size()],
+                                      clientIds[i % clientIds.size()]));
+    }
+
+    out << QString("Запуск: %1 касс, %2 с, товаров в наличии: %3\n")
+               .arg(options.workers).arg(options.durationSec).arg(catalog.size());
+    out.flush();
+
+    Database::resetTransactionStats();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (LoadWorker *worker : workers) {
+        worker->start();
+    }
+    for (LoadWorker *worker : workers) {
+        worker->wait();
+    }
+
+    double elapsedSec = timer.nsecsElapsed() / 1e9;
+
+    WorkerStats total;
+    for (LoadWorker *worker : workers) {
+        const WorkerStats &stats = worker->stats();
+        for (int i = 0; i < OperationCount; i++) {
+            total.attempts[i] += stats.attempts[i];
+            total.successes[i] += stats.successes[i];
+            total.busyFailures[i] += stats.busyFailures[i];
+            total.rejections[i] += stats.rejections[i];
+            total.latenciesNs[i] += stats.latenciesNs[i];
+        }
+        total.committedSales += stats.committedSales;
+    }
+    qDeleteAll(workers);
+
+    out << QString("\nВремя: %1 с\n").arg(elapsedSec, 0, 'f', 2);
+    out << QString("Продаж зафиксировано: %1 (%2 продаж/с)\n")
+               .arg(total.committedSales)
+               .arg(total.committedSales / elapsedSec, 0, 'f', 1);
+    TransactionStats transactions = Database::transactionStats();
+    out << QString("Транзакций: %1, повторов из-за SQLITE_BUSY: %2, отказов: %3\n\n")
+               .arg(transactions.transactions)
+               .arg(transactions.retries)
+               .arg(transactions.failures);
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+               .arg("операция", -22).arg("всего", 8).arg("успех", 8).arg("busy", 6).arg("отказ", 7)
+               .arg("p50,мс", 9).arg("p95,мс", 9).arg("p99,мс", 9).arg("max,мс", 9);
+
+    for (int i = 0; i < OperationCount; i++) {
+        QVector<qint64> latencies = total.latenciesNs[i];
+        std::sort(latencies.begin(), latencies.end());
+
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n")
+                   .arg(operationNames[i], -22)
+                   .arg(total.attempts[i], 8)
+                   .arg(total.successes[i], 8)
+                   .arg(total.busyFailures[i], 6)
+                   .arg(total.rejections[i], 7)
+                   .arg(formatMs(percentile(latencies, 0.50)), 9)
+                   .arg(formatMs(percentile(latencies, 0.95)), 9)
+                   .arg(formatMs(percentile(latencies, 0.99)), 9)
+                   .arg(formatMs(latencies.isEmpty() ? 0 : latencies.last()), 9);
+    }
+
+    StoreState after;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "loadtest_check");
+        db.setDatabaseName(options.dbPath);
+        if (!db.open() || !readState(db, before.maxSaleId, after)) {
+            out << "Не удалось проверить инварианты остатков\n";
+            return 1;
+        }
+    }
+    QSqlDatabase::removeDatabase("loadtest_check");
+
+    // Остаток каждого товара должен уменьшиться ровно на проданное
+    // плюс прирост резерва в корзинах
+    qint64 stockViolations = 0;
+    for (auto it = before.stock.constBegin(); it != before.stock.constEnd(); ++it) {
+        int productId = it.key();
+        qint64 expected = it.value()
+                          - after.sold.value(productId)
+                          - (after.reserved.value(productId) - before.reserved.value(productId));
+        if (after.stock.value(productId, expected) != expected) {
+            stockViolations++;
+        }
+    }
+
+    qint64 salesMismatch = after.saleCount - total.committedSales;
+
+    out << "\nПроверка инвариантов:\n";
+    out << QString("  отрицательных остатков: %1\n").arg(after.negativeStock);
+    out << QString("  расхождений остатка с продажами и резервом: %1\n").arg(stockViolations);
+    out << QString("  продаж в базе сверх подтвержденных: %1\n").arg(salesMismatch);
+
+    bool violated = after.negativeStock > 0 || stockViolations > 0 || salesMismatch != 0;
+    return violated ? 2 : 0;
+}